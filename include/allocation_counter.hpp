@@ -0,0 +1,10 @@
+#ifndef ALLOCATION_COUNTER_HPP
+#define ALLOCATION_COUNTER_HPP
+
+// A program linked with src/allocation_counter.cpp counts its heap
+// allocations: that file replaces the global operator new.
+
+// allocations of every thread since the program started
+unsigned long allocation_count();
+
+#endif // ALLOCATION_COUNTER_HPP
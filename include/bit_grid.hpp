@@ -0,0 +1,74 @@
+#ifndef BIT_GRID_HPP
+#define BIT_GRID_HPP
+
+#include <cstdint>
+
+#include "grid_storage.hpp"
+
+// Cells packed 64 per word, bit (col % 64) of word (col / 64 + 1).
+// Every row has a spare word on both sides and there is a spare row above
+// and below the board, so kernels can read the neighbourhood of any cell
+// without bound checking. Unless filled by a topology, the halo stays dead.
+// Rows are padded to a multiple of simd_words and the storage is aligned to
+// cache lines, so every row starts on one.
+class BitGrid {
+public:
+	using word_t = std::uint64_t;
+	static constexpr int word_bits = 64;
+	// widest vector kernel (avx512)
+	static constexpr int simd_words = 8;
+
+	BitGrid() = default;
+	BitGrid(int height, int width);
+
+	int width() const { return m_width; }
+	int height() const { return m_height; }
+	// words per row, halo and padding included
+	int stride() const { return m_stride; }
+	// cells live in words [1, last_word()]
+	int last_word() const { return m_last_word; }
+	// valid bits of the last word
+	word_t tail_mask() const { return m_tail_mask; }
+
+	// row may be in range [-1, height]
+	word_t* row(int row) {
+		return m_words.data() + static_cast<std::size_t>(row + 1) * m_stride;
+	}
+	const word_t* row(int row) const {
+		return m_words.data() + static_cast<std::size_t>(row + 1) * m_stride;
+	}
+
+	// col may be in range [-1, width]
+	bool get(int row, int col) const {
+		return (this->row(row)[word_of(col)] >> (col & (word_bits - 1))) & 1;
+	}
+	void set(int row, int col, bool value) {
+		auto& word = this->row(row)[word_of(col)];
+		auto bit = word_t(1) << (col & (word_bits - 1));
+		if (value)
+			word |= bit;
+		else
+			word &= ~bit;
+	}
+
+	void clear() {
+		m_words.fill_zero();
+	}
+
+	// wraps board edges into the halo (torus)
+	void wrap_halo();
+
+private:
+	static int word_of(int col) {
+		return (col >> 6) + 1;
+	}
+
+	int m_width = 0;
+	int m_height = 0;
+	int m_stride = 0;
+	int m_last_word = 0;
+	word_t m_tail_mask = 0;
+	GridBuffer<word_t> m_words;
+};
+
+#endif // BIT_GRID_HPP
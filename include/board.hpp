@@ -1,38 +1,233 @@
 #ifndef BOARD_HPP
 #define BOARD_HPP
 
+#include <algorithm>
+#include <cstdint>
+#include <iosfwd>
 #include <vector>
 #include <curses.h>
 #include <string>
 #include <set>
+#include <memory>
+#include <optional>
+#include <utility>
 
+#include "bit_grid.hpp"
+#include "chunked_universe.hpp"
+#include "hashlife.hpp"
+#include "life_kernel.hpp"
+#include "morton_grid.hpp"
+#include "rule.hpp"
+#include "summed_area.hpp"
+#include "thread_pool.hpp"
+#include "topology.hpp"
 
 class Board {
 	int m_width;
 	int m_height;
 
-	using board_array_t = std::vector<std::vector<bool>>;
+	using board_array_t = BitGrid;
 public:
+	enum class Algorithm {
+		dense,
+		// only recomputes tiles near last generation's changes
+		sparse,
+		// square tiles sized for the cache, the unit of parallel work
+		tiled,
+		// 64x64 tiles in z-order, plane and totalistic rules only
+		morton,
+		hashlife,
+		// tiles in a hash map, created and freed as the pattern moves
+		unbounded,
+	};
+
+	// cells per character of the ncurses view
+	enum class Glyphs {
+		// 'X' or ' '
+		ascii,
+		// 2 rows of 1, upper and lower half blocks
+		half_block,
+		// 4 rows of 2, braille dots
+		braille,
+	};
+
 	Board(int width, int height);
 
-	void set_rules(const std::set<int>& survives, const std::set<int>& born) {
-		m_survives = survives;
-		m_born = born;
+	int width() const {
+		return m_width;
+	}
+	int height() const {
+		return m_height;
+	}
+
+	// compiled into masks once, the kernel is picked for the rule
+	void set_rules(const std::set<int>& survives, const std::set<int>& born);
+	// stepped through its table, dense and sparse algorithms only
+	void set_rules(const IsotropicRule& rule);
+	// counts from a summed area table, dense and sparse algorithms only
+	void set_rules(const LargerThanLifeRule& rule);
+	// the rule of another board, e.g. a pattern read from a file
+	void set_rules(const Board& other);
+
+	// false if the rule cannot be used with the algorithm
+	bool set_algorithm(Algorithm algorithm);
+	// side of the tiled algorithm's square tiles in cells, rounded to whole
+	// words; 0 - wide tiles, two of them fit in the L2 cache
+	void set_tile_size(int cells);
+	// tiled algorithm advances that many generations per iterate(), each
+	// tile with a halo that wide in the cache (temporal blocking); plane
+	// and torus topologies and rules with range 1 only, otherwise one
+	void set_tile_generations(int generations) {
+		m_tile_generations = std::max(generations, 1);
+	}
+	// hashlife advances 2^step_log generations per iterate()
+	void set_step_log(int step_log) {
+		m_step_log = step_log;
+	}
+
+	// false with hashlife and unbounded algorithms, which have no edges
+	bool set_topology(Topology topology);
+
+	// false if the cpu does not support it
+	bool set_kernel(Kernel kernel);
+	// splits iterate() into row bands or tiles, 1 - no worker threads
+	void set_threads(int threads);
+	// with its per thread stats, nullptr without worker threads
+	std::shared_ptr<const ThreadPool> thread_pool() const {
+		return m_pool;
+	}
+
+	// keeps that many past generations for rewind(), at least 1
+	void set_history(int generations);
+	int past_generations() const {
+		sync_morton();
+		return m_past;
 	}
+	// 0 - current generation, up to past_generations()
+	const board_array_t& generation(int generations_ago) const;
+	// goes back one generation, false if there is none kept
+	bool rewind();
 
 	void iterate();
+	// advanced by one iterate() with the current settings
+	std::uint64_t generations_per_iteration() const;
 	// with bound checking
 	void add_at(int row, int col);
 	void kill_at(int row, int col);
+	// records the cells iterate(), rewind() and edits change, so renderers
+	// can redraw only those; all of them count as changed when enabled
+	void set_damage_tracking(bool enabled);
+	// anything changed since the last clear_damage()
+	bool damaged() const {
+		return m_damaged;
+	}
+	// cols [first, second) of the row changed, none if first >= second;
+	// with damage tracking only
+	std::pair<int, int> damage(int row) const {
+		return m_damage[row];
+	}
+	void clear_damage();
+
+	// ncurses, the part of the board that fits in the window with cell
+	// (top, left) in its corner; the SFML engine draws through SfmlRenderer.
+	// Glyphs other than ascii are UTF-8 and need ncursesw and a locale.
 	template <class Window>
-	void draw(Window) const;
+	void draw(Window, int top = 0, int left = 0,
+			Glyphs glyphs = Glyphs::ascii) const;
+	// only the characters over cells damage() reports
+	template <class Window>
+	void draw_damage(Window, int top = 0, int left = 0,
+			Glyphs glyphs = Glyphs::ascii) const;
 	void dump_to_file(const std::string& file);
+	// same format as dump_to_file()
+	void dump(std::ostream& stream);
 private:
-	board_array_t m_board;
-	board_array_t m_temporary_board;
+	void iterate_sparse(RuleMasks rule);
+	void iterate_tiled(RuleMasks rule);
+	void iterate_temporal(RuleMasks rule, int generations);
+	void iterate_morton(RuleMasks rule);
+	// whether iterate() uses iterate_temporal()
+	bool temporal_blocking() const;
+	// kernel for m_rule, the table of m_isotropic or m_range_rule
+	void step_rect(const board_array_t& board, board_array_t& next_board,
+			int row_begin, int row_end, int word_begin, int word_end,
+			RuleMasks rule);
+	void mark_changed(int row, int col);
+	void mark_all_changed();
+	void add_damage(int row, int col_begin, int col_end);
+	void mark_all_damaged();
+	// words that differ between the current generation and the one before
+	void find_damage();
+	void advance();
+	// writes generations the morton algorithm stepped without storing
+	// them into the ring
+	void sync_morton() const;
+	// characters [x_begin, x_end) of line y of the view
+	void draw_glyphs(WINDOW* scr, Glyphs glyphs, int y, int x_begin,
+			int x_end, int top, int left) const;
+
+	board_array_t& current() {
+		sync_morton();
+		return m_history[m_current];
+	}
+	const board_array_t& current() const {
+		sync_morton();
+		return m_history[m_current];
+	}
+	board_array_t& next() {
+		return m_history[(m_current + 1) % m_history.size()];
+	}
+
+	// ring of generations, iterate() writes the one after m_current, which
+	// is the oldest, instead of copying buffers; the morton algorithm
+	// fills it when it is read
+	mutable std::vector<board_array_t> m_history;
+	mutable int m_current;
+	mutable int m_past;
+	RuleMasks m_rule;
+	std::optional<IsotropicRule> m_isotropic;
+	std::optional<LargerThanLifeRule> m_range_rule;
+	// one per thread, each over the rectangle it steps while m_range_rule
+	// is used, so a sparse step sums only the active tiles
+	std::vector<SummedAreaTable> m_sums;
+	Kernel m_kernel_choice;
+	life_kernel_t m_kernel;
+	life_tile_kernel_t m_tile_kernel;
+	// shared by copies of the board
+	std::shared_ptr<ThreadPool> m_pool;
+	Algorithm m_algorithm;
+	Topology m_topology;
+
+	static constexpr int sparse_tile_rows = 64;
+	static constexpr int sparse_tile_words = 4;
+	int m_tiles_x;
+	int m_tiles_y;
+	// changed in the last generation or edited since, bytes instead of
+	// bits as the pool writes them concurrently
+	std::vector<unsigned char> m_tile_changed;
+	std::vector<unsigned char> m_next_tile_changed;
+	// stepped or copied this generation
+	std::vector<int> m_active_tiles;
+
+	int m_tile_rows;
+	int m_tile_words;
+	int m_tile_generations;
+	// two tiles with halos per thread for temporal blocking
+	std::vector<board_array_t> m_tile_buffers;
+
+	// unbounded universes, the board shows their part at (0, 0)
+	std::optional<HashLife> m_hashlife;
+	std::optional<ChunkedUniverse> m_chunked;
+	// current and previous generation of the morton algorithm
+	std::vector<MortonGrid> m_morton;
+	// generations m_morton is ahead of the ring
+	mutable int m_morton_steps;
+	int m_step_log;
 
-	std::set<int> m_survives;
-	std::set<int> m_born;
+	bool m_damage_tracking;
+	bool m_damaged;
+	// changed cols of every row, see damage()
+	std::vector<std::pair<int, int>> m_damage;
 
 public:
 	struct Position {
@@ -72,7 +267,7 @@ public:
 		}
 
 		bool operator*() {
-			return m_board->m_board[row][col];
+			return m_board->current().get(row, col);
 		}
 	private:
 		const Board* m_board;
@@ -99,5 +294,10 @@ public:
 	}
 };
 
+const char* algorithm_name(Board::Algorithm algorithm);
+std::optional<Board::Algorithm> algorithm_from_name(const std::string& name);
+std::optional<Board::Glyphs> glyphs_from_name(const std::string& name);
+// rows and cols of cells in a character
+std::pair<int, int> glyph_size(Board::Glyphs glyphs);
 
 #endif // BOARD_HPP
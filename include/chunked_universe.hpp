@@ -0,0 +1,63 @@
+#ifndef CHUNKED_UNIVERSE_HPP
+#define CHUNKED_UNIVERSE_HPP
+
+#include <array>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "bit_grid.hpp"
+#include "life_kernel.hpp"
+
+// Unbounded universe made of 64x64 tiles kept in a hash map. A tile is
+// created when cells are born in it and freed when all of its cells die,
+// so memory follows the live pattern instead of its bounding box.
+class ChunkedUniverse {
+public:
+	static constexpr int tile_size = BitGrid::word_bits;
+	// word n holds row n of the tile
+	using tile_t = std::array<BitGrid::word_t, tile_size>;
+
+	explicit ChunkedUniverse(RuleMasks rule);
+	// live tiles are copied, spare ones are not
+	ChunkedUniverse(const ChunkedUniverse& other);
+	ChunkedUniverse(ChunkedUniverse&& other) = default;
+	ChunkedUniverse& operator=(const ChunkedUniverse& other);
+	ChunkedUniverse& operator=(ChunkedUniverse&& other) = default;
+
+	void set_rule(RuleMasks rule) {
+		m_rule = rule;
+	}
+
+	void set(std::int64_t row, std::int64_t col, bool alive);
+	bool get(std::int64_t row, std::int64_t col) const;
+
+	void step();
+	std::uint64_t generation() const {
+		return m_generation;
+	}
+	std::uint64_t population() const;
+	std::size_t tile_count() const {
+		return m_tiles.size();
+	}
+
+	// overwrites grid with the cells below and right of (top, left)
+	void render(BitGrid& grid, std::int64_t top, std::int64_t left) const;
+
+private:
+	using key_t = std::uint64_t;
+	using tile_map_t = std::unordered_map<key_t, tile_t>;
+
+	static key_t key(std::int64_t tile_row, std::int64_t tile_col);
+	static std::int64_t tile_of(std::int64_t coordinate);
+	const tile_t* find(std::int64_t tile_row, std::int64_t tile_col) const;
+
+	RuleMasks m_rule;
+	tile_map_t m_tiles;
+	tile_map_t m_next_tiles;
+	// nodes of freed tiles, reused by step() instead of allocating
+	std::vector<tile_map_t::node_type> m_spare_tiles;
+	std::uint64_t m_generation;
+};
+
+#endif // CHUNKED_UNIVERSE_HPP
@@ -0,0 +1,81 @@
+#ifndef DENSITY_PYRAMID_HPP
+#define DENSITY_PYRAMID_HPP
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "bit_grid.hpp"
+
+// Live cells of a board at every power of two scale. Level 0 is the board
+// itself, every cell of level k counts the live cells of a 2^k x 2^k
+// block, the sum of its 2x2 children on level k - 1. The top level is a
+// single cell. update() only recomputes the blocks above 64x64 tiles
+// whose cells changed since the last call.
+// Level 1 is read from the cells when asked, from level 2 on every level
+// is stored in the narrowest counts that hold 4^k, so all of them take
+// less memory than the cells.
+class DensityPyramid {
+public:
+	using count_t = std::uint32_t;
+
+	DensityPyramid(int height, int width);
+
+	void update(const BitGrid& grid);
+
+	int levels() const {
+		return static_cast<int>(m_sizes.size());
+	}
+	int width(int level) const {
+		return m_sizes[level].first;
+	}
+	int height(int level) const {
+		return m_sizes[level].second;
+	}
+	// of a 2^level x 2^level block, cells outside the board are dead
+	count_t count(int level, int row, int col) const {
+		if (level < 2)
+			return cell_count(level, row, col);
+		auto& layer = m_levels[level - 2];
+		auto index = static_cast<std::size_t>(row) * layer.width + col;
+		if (!layer.narrow.empty())
+			return layer.narrow[index];
+		if (!layer.medium.empty())
+			return layer.medium[index];
+		return layer.wide[index];
+	}
+	// cells as of the last update()
+	const BitGrid& cells() const {
+		return m_cells;
+	}
+
+private:
+	// one of the vectors holds the counts
+	struct Level {
+		int width;
+		int height;
+		// up to level 3
+		std::vector<std::uint8_t> narrow;
+		// up to level 7
+		std::vector<std::uint16_t> medium;
+		std::vector<count_t> wide;
+	};
+
+	// levels 0 and 1
+	count_t cell_count(int level, int row, int col) const;
+	// level 2 from the cells, rows and cols in level 2 cells
+	void count_cells(int row_begin, int row_end, int col_begin, int col_end);
+	// level from the one below it
+	void count_level(int level, int row_begin, int row_end,
+			int col_begin, int col_end);
+
+	BitGrid m_cells;
+	// words of the 64 row band update() is at whose cells changed
+	std::vector<char> m_changed;
+	// width and height of every level
+	std::vector<std::pair<int, int>> m_sizes;
+	// level k at k - 2
+	std::vector<Level> m_levels;
+};
+
+#endif // DENSITY_PYRAMID_HPP
@@ -14,6 +14,8 @@ public:
 
 	void setSpeed(double seconds);
 	void setMaxIterations(int max);
+	// ncurses only
+	void setGlyphs(Board::Glyphs glyphs);
 	void initializeField(int y, int x);
 
 	void loop();
@@ -23,11 +25,14 @@ private:
 	static void disableDisplay();
 	void display_help();
 	void display_save();
+	// asks for a cell, false if none was given
+	bool display_jump(int& row, int& col);
 	Board m_board;
 	Window m_scr;
 
 	int m_max_iterations;
 	std::chrono::milliseconds m_iteration_duration;
+	Board::Glyphs m_glyphs;
 };
 
 
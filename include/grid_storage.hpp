@@ -0,0 +1,121 @@
+#ifndef GRID_STORAGE_HPP
+#define GRID_STORAGE_HPP
+
+#include <cstddef>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+enum class HugePages {
+	// small pages only
+	off,
+	// madvise, the kernel backs the buffer with huge pages when it can
+	transparent,
+	// MAP_HUGETLB from the pages reserved in vm.nr_hugepages, transparent
+	// when there are not enough of them
+	reserved,
+};
+
+// One arena for the cells of every grid. Buffers are aligned to cache
+// lines, large ones are mapped straight from the kernel and can be backed
+// by huge pages. Released buffers are kept by size and handed out again,
+// so the generations of a board and copies of it reuse the same memory
+// instead of going through malloc and faulting fresh pages in.
+class GridStorage {
+public:
+	static constexpr std::size_t alignment = 64;
+
+	// shared by all grids, never destroyed
+	static GridStorage& instance();
+
+	GridStorage(const GridStorage&) = delete;
+	GridStorage& operator=(const GridStorage&) = delete;
+
+	// for buffers allocated from now on
+	void set_huge_pages(HugePages huge_pages);
+	// released bytes kept for reuse, the rest goes back to the system
+	void set_cache_limit(std::size_t bytes);
+	// gives every kept buffer back to the system
+	void trim();
+
+	// at least bytes, aligned to alignment, contents undefined
+	void* allocate(std::size_t bytes);
+	// bytes as passed to allocate()
+	void release(void* buffer, std::size_t bytes);
+
+private:
+	GridStorage() = default;
+
+	static std::size_t block_size(std::size_t bytes);
+	void* map(std::size_t size);
+	static void unmap(void* buffer, std::size_t size);
+
+	std::mutex m_mutex;
+	HugePages m_huge_pages = HugePages::transparent;
+	std::size_t m_cache_limit = std::size_t(256) << 20;
+	std::size_t m_cached = 0;
+	// released blocks by block size
+	std::map<std::size_t, std::vector<void*>> m_free;
+};
+
+// RAII array of trivial values in GridStorage
+template <class T>
+class GridBuffer {
+public:
+	GridBuffer() = default;
+	explicit GridBuffer(std::size_t size) : m_size(size) {
+		if (m_size)
+			m_data = static_cast<T*>(
+					GridStorage::instance().allocate(m_size * sizeof(T)));
+	}
+	GridBuffer(const GridBuffer& other) : GridBuffer(other.m_size) {
+		if (m_size)
+			std::memcpy(m_data, other.m_data, m_size * sizeof(T));
+	}
+	GridBuffer(GridBuffer&& other) noexcept :
+			m_data(std::exchange(other.m_data, nullptr)),
+			m_size(std::exchange(other.m_size, 0)) {
+	}
+	~GridBuffer() {
+		if (m_data)
+			GridStorage::instance().release(m_data, m_size * sizeof(T));
+	}
+
+	// keeps its own buffer when the sizes match
+	GridBuffer& operator=(const GridBuffer& other) {
+		if (this == &other)
+			return *this;
+		if (m_size != other.m_size)
+			*this = GridBuffer(other.m_size);
+		if (m_size)
+			std::memcpy(m_data, other.m_data, m_size * sizeof(T));
+		return *this;
+	}
+	GridBuffer& operator=(GridBuffer&& other) noexcept {
+		std::swap(m_data, other.m_data);
+		std::swap(m_size, other.m_size);
+		return *this;
+	}
+
+	T* data() { return m_data; }
+	const T* data() const { return m_data; }
+	std::size_t size() const { return m_size; }
+
+	void fill_zero() {
+		if (m_size)
+			std::memset(m_data, 0, m_size * sizeof(T));
+	}
+
+private:
+	T* m_data = nullptr;
+	std::size_t m_size = 0;
+};
+
+const char* huge_pages_name(HugePages huge_pages);
+std::optional<HugePages> huge_pages_from_name(const std::string& name);
+
+#endif // GRID_STORAGE_HPP
@@ -0,0 +1,88 @@
+#ifndef HASHLIFE_HPP
+#define HASHLIFE_HPP
+
+#include <array>
+#include <cstdint>
+#include <deque>
+#include <unordered_map>
+#include <vector>
+
+#include "bit_grid.hpp"
+#include "life_kernel.hpp"
+
+// Unbounded universe stored as a hash-consed quadtree. Every node caches
+// its centre advanced in time, so repeating patterns are computed once and
+// a single step() can jump 2^k generations.
+class HashLife {
+public:
+	explicit HashLife(RuleMasks rule);
+	// nodes are copied without cached results
+	HashLife(const HashLife& other);
+	HashLife(HashLife&& other) = default;
+	HashLife& operator=(const HashLife& other);
+	HashLife& operator=(HashLife&& other) = default;
+
+	void set_rule(RuleMasks rule);
+
+	void set(std::int64_t row, std::int64_t col, bool alive);
+	bool get(std::int64_t row, std::int64_t col) const;
+
+	// advances the universe by 2^step_log generations
+	void step(int step_log);
+	std::uint64_t generation() const {
+		return m_generation;
+	}
+	std::uint64_t population() const;
+
+	// overwrites grid with the cells below and right of (top, left)
+	void render(BitGrid& grid, std::int64_t top, std::int64_t left) const;
+
+	static constexpr int max_step_log = 48;
+
+private:
+	struct Node {
+		const Node* nw;
+		const Node* ne;
+		const Node* sw;
+		const Node* se;
+		int level;
+		std::uint64_t population;
+		// centre after 2^result_step generations
+		mutable const Node* result;
+		mutable int result_step;
+	};
+
+	using node_key_t = std::array<const Node*, 4>;
+	struct NodeKeyHash {
+		std::size_t operator()(const node_key_t& key) const;
+	};
+
+	const Node* join(const Node* nw, const Node* ne,
+			const Node* sw, const Node* se);
+	const Node* empty(int level);
+	const Node* centre(const Node* node);
+	const Node* expand(const Node* node);
+	const Node* set(const Node* node, std::int64_t row, std::int64_t col,
+			bool alive);
+	const Node* base_step(const Node* node);
+	const Node* successor(const Node* node, int step_log);
+	const Node* copy_tree(const Node* node,
+			std::unordered_map<const Node*, const Node*>& copied);
+	void render(const Node* node, std::int64_t row, std::int64_t col,
+			BitGrid& grid, std::int64_t top, std::int64_t left) const;
+	// root covers [-half, half) in both directions
+	std::int64_t half_size() const {
+		return std::int64_t(1) << (m_root->level - 1);
+	}
+
+	RuleMasks m_rule;
+	std::deque<Node> m_nodes;
+	std::unordered_map<node_key_t, const Node*, NodeKeyHash> m_table;
+	std::vector<const Node*> m_empty;
+	const Node* m_dead;
+	const Node* m_alive;
+	const Node* m_root;
+	std::uint64_t m_generation;
+};
+
+#endif // HASHLIFE_HPP
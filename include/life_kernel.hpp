@@ -0,0 +1,57 @@
+#ifndef LIFE_KERNEL_HPP
+#define LIFE_KERNEL_HPP
+
+#include <cstdint>
+#include <optional>
+#include <string>
+
+#include "bit_grid.hpp"
+
+// bit n set <=> rule applies for n live neighbours
+struct RuleMasks {
+	std::uint32_t born;
+	std::uint32_t survives;
+};
+
+// cells per instruction: 64, 128, 256, 512
+enum class Kernel {
+	scalar,
+	sse2,
+	avx2,
+	avx512,
+	automatic,
+};
+
+// computes words [word_begin, word_end) of rows [row_begin, row_end) of
+// the next generation
+using life_kernel_t = void (*)(const BitGrid& src, BitGrid& dst,
+		int row_begin, int row_end, int word_begin, int word_end,
+		RuleMasks rule);
+
+// steps one 64x64 tile stored one word per row; neighbours are the 3x3
+// tiles around it in row major order, the tile itself in the middle
+using life_tile_kernel_t = void (*)(const BitGrid::word_t* const neighbours[9],
+		BitGrid::word_t* out, RuleMasks rule);
+// with the scalar kernel
+void life_step_tile(const BitGrid::word_t* const neighbours[9],
+		BitGrid::word_t* out, RuleMasks rule);
+
+// same area as life_kernel_t for a rule given as a table of the next
+// state indexed by the 3x3 neighbourhood (see IsotropicRule), one cell at
+// a time
+void life_step_table(const BitGrid& src, BitGrid& dst,
+		int row_begin, int row_end, int word_begin, int word_end,
+		const unsigned char* table);
+
+bool kernel_supported(Kernel kernel);
+// best kernel supported by this cpu
+Kernel best_kernel();
+// automatic resolves to best_kernel(); nullptr if not supported
+// B3/S23, B36/S23 and B2/S get kernels specialized for them
+life_kernel_t life_kernel(Kernel kernel, RuleMasks rule);
+life_tile_kernel_t life_tile_kernel(Kernel kernel, RuleMasks rule);
+
+const char* kernel_name(Kernel kernel);
+std::optional<Kernel> kernel_from_name(const std::string& name);
+
+#endif // LIFE_KERNEL_HPP
@@ -0,0 +1,247 @@
+#ifndef LIFE_KERNEL_IMPL_HPP
+#define LIFE_KERNEL_IMPL_HPP
+
+// Shared body of the life kernels. Every kernel translation unit is
+// compiled for its own instruction set and instantiates this with its own
+// vector type, so everything here has internal linkage and avoids out of
+// line library templates, which the linker could share between them.
+
+#include <cstring>
+
+#include "life_kernel.hpp"
+
+// kernel of each instruction set specialized for the rule
+life_kernel_t life_kernel_scalar(RuleMasks rule);
+life_kernel_t life_kernel_sse2(RuleMasks rule);
+life_kernel_t life_kernel_avx2(RuleMasks rule);
+life_kernel_t life_kernel_avx512(RuleMasks rule);
+life_tile_kernel_t life_tile_kernel_scalar(RuleMasks rule);
+life_tile_kernel_t life_tile_kernel_sse2(RuleMasks rule);
+life_tile_kernel_t life_tile_kernel_avx2(RuleMasks rule);
+life_tile_kernel_t life_tile_kernel_avx512(RuleMasks rule);
+
+namespace {
+
+using word_t = BitGrid::word_t;
+
+// Vec is word_t or a gcc/clang vector of word_t, both have bitwise
+// operators and per lane shifts
+template <class Vec>
+inline Vec load(const word_t* word) {
+	Vec result;
+	std::memcpy(&result, word, sizeof(Vec));
+	return result;
+}
+
+template <class Vec>
+inline void store(word_t* word, Vec value) {
+	std::memcpy(word, &value, sizeof(Vec));
+}
+
+template <class Vec>
+inline void half_add(Vec a, Vec b, Vec& sum, Vec& carry) {
+	sum = a ^ b;
+	carry = a & b;
+}
+
+template <class Vec>
+inline void full_add(Vec a, Vec b, Vec c, Vec& sum, Vec& carry) {
+	Vec ab = a ^ b;
+	sum = ab ^ c;
+	carry = (a & b) | (ab & c);
+}
+
+// neighbours from the west and east shifted onto the cell position
+template <class Vec>
+inline Vec west(const word_t* word) {
+	return (load<Vec>(word) << 1) | (load<Vec>(word - 1) >> 63);
+}
+
+template <class Vec>
+inline Vec east(const word_t* word) {
+	return (load<Vec>(word) >> 1) | (load<Vec>(word + 1) << 63);
+}
+
+// Rules get the neighbour count as bit planes (ones, twos, fours, eights)
+// and return the next state. The common ones are written out, so the
+// compiler folds them into a few logic instructions; anything else goes
+// through the generic rule, which tests the masks for every count.
+struct GenericRule {
+	template <class Vec>
+	static Vec next(Vec alive, Vec ones, Vec twos, Vec fours, Vec eights,
+			RuleMasks rule) {
+		Vec result = {};
+		for (int count = 0; count <= 8; ++count) {
+			bool born = (rule.born >> count) & 1;
+			bool survives = (rule.survives >> count) & 1;
+			if (!born && !survives)
+				continue;
+			Vec equal = (count & 1 ? ones : ~ones) &
+				(count & 2 ? twos : ~twos) &
+				(count & 4 ? fours : ~fours) &
+				(count & 8 ? eights : ~eights);
+			if (born && survives)
+				result |= equal;
+			else if (born)
+				result |= equal & ~alive;
+			else
+				result |= equal & alive;
+		}
+		return result;
+	}
+};
+
+// B3/S23
+struct LifeRule {
+	static constexpr RuleMasks masks = { 1u << 3, 1u << 2 | 1u << 3 };
+
+	template <class Vec>
+	static Vec next(Vec alive, Vec ones, Vec twos, Vec fours, Vec eights,
+			RuleMasks) {
+		return twos & ~fours & ~eights & (ones | alive);
+	}
+};
+
+// B36/S23
+struct HighLifeRule {
+	static constexpr RuleMasks masks = { 1u << 3 | 1u << 6, 1u << 2 | 1u << 3 };
+
+	template <class Vec>
+	static Vec next(Vec alive, Vec ones, Vec twos, Vec fours, Vec eights,
+			RuleMasks) {
+		return twos & ~eights &
+			((~fours & (ones | alive)) | (fours & ~ones & ~alive));
+	}
+};
+
+// B2/S
+struct SeedsRule {
+	static constexpr RuleMasks masks = { 1u << 2, 0 };
+
+	template <class Vec>
+	static Vec next(Vec alive, Vec ones, Vec twos, Vec fours, Vec eights,
+			RuleMasks) {
+		return ~alive & ~ones & twos & ~fours & ~eights;
+	}
+};
+
+// the rows above, at and below the cells, each with its west and east
+// neighbours shifted onto the cell position
+template <class Vec, class Rule>
+inline Vec step_neighbours(Vec above_west, Vec above, Vec above_east,
+		Vec west, Vec current, Vec east,
+		Vec below_west, Vec below, Vec below_east, RuleMasks rule) {
+	// neighbour count as four bit planes, summed with full adders
+	Vec sum_above, carry_above;
+	full_add(above_west, above, above_east, sum_above, carry_above);
+	Vec sum_below, carry_below;
+	full_add(below_west, below, below_east, sum_below, carry_below);
+	Vec sum_middle, carry_middle;
+	half_add(west, east, sum_middle, carry_middle);
+
+	Vec ones, carry_ones;
+	full_add(sum_above, sum_below, sum_middle, ones, carry_ones);
+	Vec twos_partial, fours_a;
+	full_add(carry_above, carry_below, carry_middle, twos_partial, fours_a);
+	Vec twos, fours_b;
+	half_add(twos_partial, carry_ones, twos, fours_b);
+	Vec fours, eights;
+	half_add(fours_a, fours_b, fours, eights);
+
+	return Rule::next(current, ones, twos, fours, eights, rule);
+}
+
+template <class Vec, class Rule>
+inline Vec step_words(const word_t* above, const word_t* current,
+		const word_t* below, RuleMasks rule) {
+	return step_neighbours<Vec, Rule>(
+			west<Vec>(above), load<Vec>(above), east<Vec>(above),
+			west<Vec>(current), load<Vec>(current), east<Vec>(current),
+			west<Vec>(below), load<Vec>(below), east<Vec>(below), rule);
+}
+
+// whole vectors first, the words left over one by one
+template <class Vec, class Rule>
+void step_rows(const BitGrid& src, BitGrid& dst, int row_begin, int row_end,
+		int word_begin, int word_end, RuleMasks rule) {
+	constexpr int lanes = sizeof(Vec) / sizeof(word_t);
+	auto last = src.last_word();
+	for (int row = row_begin; row < row_end; ++row) {
+		auto above = src.row(row - 1);
+		auto current = src.row(row);
+		auto below = src.row(row + 1);
+		auto out = dst.row(row);
+		int word = word_begin;
+		for (; word + lanes <= word_end; word += lanes)
+			store(out + word, step_words<Vec, Rule>(above + word,
+					current + word, below + word, rule));
+		for (; word < word_end; ++word)
+			out[word] = step_words<word_t, Rule>(above + word,
+					current + word, below + word, rule);
+		if (word_begin <= last && last < word_end)
+			out[last] &= src.tail_mask();
+	}
+}
+
+// The tile in neighbours[4], one word per row, with the tiles around it.
+// Rows -1 to 64 of the tile column and of the columns west and east of it
+// are gathered first, then a vector covers consecutive rows.
+template <class Vec, class Rule>
+void step_tile(const word_t* const neighbours[9], word_t* out,
+		RuleMasks rule) {
+	constexpr int size = BitGrid::word_bits;
+	constexpr int lanes = sizeof(Vec) / sizeof(word_t);
+	word_t columns[3][size + 2];
+	for (int x = 0; x < 3; ++x) {
+		columns[x][0] = neighbours[x][size - 1];
+		std::memcpy(columns[x] + 1, neighbours[3 + x], size * sizeof(word_t));
+		columns[x][size + 1] = neighbours[6 + x][0];
+	}
+
+	auto shifted = [&](int row, Vec& west, Vec& current, Vec& east) {
+		current = load<Vec>(columns[1] + row + 1);
+		west = (current << 1) | (load<Vec>(columns[0] + row + 1) >> 63);
+		east = (current >> 1) | (load<Vec>(columns[2] + row + 1) << 63);
+	};
+	for (int row = 0; row < size; row += lanes) {
+		Vec above_west, above, above_east;
+		shifted(row - 1, above_west, above, above_east);
+		Vec west, current, east;
+		shifted(row, west, current, east);
+		Vec below_west, below, below_east;
+		shifted(row + 1, below_west, below, below_east);
+		store(out + row, step_neighbours<Vec, Rule>(above_west, above,
+				above_east, west, current, east,
+				below_west, below, below_east, rule));
+	}
+}
+
+inline bool same_rule(RuleMasks a, RuleMasks b) {
+	return a.born == b.born && a.survives == b.survives;
+}
+
+template <class Vec>
+life_kernel_t select_kernel(RuleMasks rule) {
+	if (same_rule(rule, LifeRule::masks))
+		return step_rows<Vec, LifeRule>;
+	if (same_rule(rule, HighLifeRule::masks))
+		return step_rows<Vec, HighLifeRule>;
+	if (same_rule(rule, SeedsRule::masks))
+		return step_rows<Vec, SeedsRule>;
+	return step_rows<Vec, GenericRule>;
+}
+
+template <class Vec>
+life_tile_kernel_t select_tile_kernel(RuleMasks rule) {
+	if (same_rule(rule, LifeRule::masks))
+		return step_tile<Vec, LifeRule>;
+	if (same_rule(rule, HighLifeRule::masks))
+		return step_tile<Vec, HighLifeRule>;
+	if (same_rule(rule, SeedsRule::masks))
+		return step_tile<Vec, SeedsRule>;
+	return step_tile<Vec, GenericRule>;
+}
+
+} // namespace
+
+#endif // LIFE_KERNEL_IMPL_HPP
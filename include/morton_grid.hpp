@@ -0,0 +1,84 @@
+#ifndef MORTON_GRID_HPP
+#define MORTON_GRID_HPP
+
+#include <utility>
+#include <vector>
+
+#include "bit_grid.hpp"
+#include "grid_storage.hpp"
+#include "life_kernel.hpp"
+
+// Board of 64x64 tiles, each stored as 64 words (one per row), laid out
+// in Z-order (Morton order) in one cache line aligned allocation. Tiles
+// close in either direction are close in memory, so stepping a tile with
+// its eight neighbours, or reading any 2D region, touches few pages.
+class MortonGrid {
+public:
+	using word_t = BitGrid::word_t;
+	static constexpr int tile_size = BitGrid::word_bits;
+
+	MortonGrid(int height, int width);
+
+	int width() const { return m_width; }
+	int height() const { return m_height; }
+	int tiles_x() const { return m_tiles_x; }
+	int tiles_y() const { return m_tiles_y; }
+	int tile_count() const { return m_tiles_x * m_tiles_y; }
+
+	// tile with z-order index slot
+	word_t* slot(int slot) {
+		return m_words.data() + static_cast<std::size_t>(slot) * tile_size;
+	}
+	const word_t* slot(int slot) const {
+		return m_words.data() + static_cast<std::size_t>(slot) * tile_size;
+	}
+	int slot_of(int tile_y, int tile_x) const {
+		return m_slots[tile_y * m_tiles_x + tile_x];
+	}
+	// (tile_y, tile_x) of a slot
+	std::pair<int, int> tile_of(int slot) const {
+		auto tile = m_tiles[slot];
+		return { tile / m_tiles_x, tile % m_tiles_x };
+	}
+	// tiles outside the board read as a dead tile
+	const word_t* tile(int tile_y, int tile_x) const {
+		if (tile_y < 0 || tile_y >= m_tiles_y ||
+				tile_x < 0 || tile_x >= m_tiles_x)
+			return slot(tile_count());
+		return slot(slot_of(tile_y, tile_x));
+	}
+
+	bool get(int row, int col) const {
+		auto word = tile(row / tile_size, col / tile_size)[row % tile_size];
+		return (word >> (col % tile_size)) & 1;
+	}
+	void set(int row, int col, bool value);
+
+	// copies all cells from or to a grid of the same size
+	void load(const BitGrid& grid);
+	void store(BitGrid& grid) const;
+
+	// steps the tile in slot of src into the same slot of dst with kernel,
+	// cells beyond the board stay dead
+	friend void life_step_slot(const MortonGrid& src, MortonGrid& dst,
+			int slot, life_tile_kernel_t kernel, RuleMasks rule);
+
+private:
+	int m_width;
+	int m_height;
+	int m_tiles_x;
+	int m_tiles_y;
+	// row major tile index <-> z-order slot
+	std::vector<int> m_slots;
+	std::vector<int> m_tiles;
+	// tile_count() tiles and a dead one after them
+	GridBuffer<word_t> m_words;
+	// valid bits of the last tile column and rows of the last tile row
+	word_t m_tail_mask;
+	int m_tail_rows;
+};
+
+void life_step_slot(const MortonGrid& src, MortonGrid& dst, int slot,
+		life_tile_kernel_t kernel, RuleMasks rule);
+
+#endif // MORTON_GRID_HPP
@@ -9,5 +9,11 @@
 
 std::optional<Board> parse_from_file(const std::string& filename);
 std::optional<Board> parse_from_stdin();
+// name is used in messages
+std::optional<Board> parse_from_stream(std::istream& stream,
+		const std::string& name);
+// only splits the stream into tokens, for measuring the lexer on its
+// own; number of tokens, -1 on a lexical error
+long lex_stream(std::istream& stream);
 
 #endif
@@ -0,0 +1,39 @@
+#ifndef RULE_HPP
+#define RULE_HPP
+
+#include <array>
+#include <optional>
+#include <string>
+
+// Isotropic non-totalistic rule in Hensel notation, e.g. B2-a/S12.
+// next is indexed by the whole 3x3 neighbourhood, bit 3 * row + col with
+// row 0 above and col 0 west of the cell, so the cell itself is bit 4.
+struct IsotropicRule {
+	// conditions as written after B and S
+	std::string born;
+	std::string survives;
+	std::array<unsigned char, 512> next;
+};
+
+// nullopt if a condition is not valid Hensel notation
+std::optional<IsotropicRule> isotropic_rule(const std::string& born,
+		const std::string& survives);
+
+// Larger than Life rule, e.g. R5/B34-45/S34-58. Counts cover the square of
+// side 2 * range + 1 around the cell, the cell itself included; an empty
+// interval has min > max.
+struct LargerThanLifeRule {
+	// within the tiles around a change the sparse engine steps
+	static constexpr int max_range = 32;
+
+	int range;
+	int born_min;
+	int born_max;
+	int survives_min;
+	int survives_max;
+};
+
+// e.g. R5/B34-45/S34-58
+std::string rule_name(const LargerThanLifeRule& rule);
+
+#endif // RULE_HPP
@@ -0,0 +1,54 @@
+#ifndef SFML_RENDERER_HPP
+#define SFML_RENDERER_HPP
+
+#include <array>
+#include <cstdint>
+#include <vector>
+#include <SFML/Graphics.hpp>
+
+#include "bit_grid.hpp"
+#include "density_pyramid.hpp"
+
+// Visible part of the board as a texture with at most one texel per
+// pixel. Zoomed out, a texel is a block of a DensityPyramid level, shaded
+// by its population, so a frame costs the same for any board size and
+// any population. The view is the board cell at the top left pixel and
+// the size of a cell in pixels.
+class SfmlRenderer {
+public:
+	SfmlRenderer(int height, int width);
+
+	void update(const BitGrid& grid);
+	void draw(sf::RenderTarget& target);
+
+	// whole board, centred in a target of that size
+	void fit(sf::Vector2u size);
+	// the cell under pixel stays where it is
+	void zoom(float factor, sf::Vector2f pixel);
+	void pan(sf::Vector2f pixels);
+
+private:
+	// texels of the visible blocks of a level
+	void fill(int level, int row_begin, int row_end,
+			int col_begin, int col_end);
+
+	int m_width;
+	int m_height;
+	DensityPyramid m_pyramid;
+	// board cells at the top left corner of the target
+	double m_left = 0;
+	double m_top = 0;
+	// pixels per cell
+	double m_scale = 1;
+	// the texture shows the current board and view
+	bool m_fresh = false;
+	sf::Vector2u m_target_size;
+
+	std::vector<std::uint32_t> m_pixels;
+	// texel of every population / block area, in 1/255
+	std::array<std::uint32_t, 256> m_shades;
+	sf::Texture m_texture;
+	sf::Sprite m_sprite;
+};
+
+#endif // SFML_RENDERER_HPP
@@ -0,0 +1,48 @@
+#ifndef SUMMED_AREA_HPP
+#define SUMMED_AREA_HPP
+
+#include <cstdint>
+#include <vector>
+
+#include "bit_grid.hpp"
+#include "rule.hpp"
+#include "topology.hpp"
+
+// Live cells above and left of every position of a generation, so the
+// population of any square is four lookups whatever its size. Covers a
+// rectangle of the board extended by range cells on every side, filled
+// as the topology says where it crosses the board's edges.
+class SummedAreaTable {
+public:
+	// rows [row_begin, row_end) and cols [col_begin, col_end) can be
+	// counted; reuses the memory of the last build
+	void build(const BitGrid& grid, int range, Topology topology,
+			int row_begin, int row_end, int col_begin, int col_end);
+
+	// live cells in the square of side 2 * range + 1 around the cell
+	std::uint32_t count(int row, int col) const {
+		auto top = static_cast<std::size_t>(row - m_row) * m_stride;
+		auto bottom = top + static_cast<std::size_t>(2 * m_range + 1) * m_stride;
+		auto left = col - m_col;
+		auto right = left + 2 * m_range + 1;
+		return m_sums[bottom + right] - m_sums[top + right] -
+			m_sums[bottom + left] + m_sums[top + left];
+	}
+
+private:
+	int m_range = 0;
+	// first row and col of the rectangle
+	int m_row = 0;
+	int m_col = 0;
+	int m_stride = 0;
+	// row and column 0 are zero
+	std::vector<std::uint32_t> m_sums;
+};
+
+// same area as life_kernel_t for a Larger than Life rule, sums built from
+// src with the rule's range over at least that area
+void life_step_range(const SummedAreaTable& sums, const BitGrid& src,
+		BitGrid& dst, int row_begin, int row_end, int word_begin,
+		int word_end, const LargerThanLifeRule& rule);
+
+#endif // SUMMED_AREA_HPP
@@ -0,0 +1,111 @@
+#ifndef THREAD_POOL_HPP
+#define THREAD_POOL_HPP
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+// Threads are started once and wait for work between calls to run(), so a
+// generation only pays for one wake up and one barrier.
+class ThreadPool {
+public:
+	// per thread since the pool started or reset_stats()
+	struct Stats {
+		unsigned long tasks = 0;
+		// task ranges taken from other threads
+		unsigned long steals = 0;
+		// spent in tasks
+		std::chrono::nanoseconds busy{0};
+	};
+
+	// threads includes the calling thread
+	explicit ThreadPool(int threads);
+	~ThreadPool();
+
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+
+	int size() const {
+		return static_cast<int>(m_workers.size()) + 1;
+	}
+
+	// index of the calling thread in [0, size()), 0 for threads outside
+	// any pool
+	static int thread_index();
+
+	// calls task(index) for every index in [0, tasks), returns when all
+	// of them are done
+	template <class Task>
+	void run(int tasks, Task&& task) {
+		using task_t = std::remove_reference_t<Task>;
+		run_tasks(tasks, [](void* context, int index) {
+			(*static_cast<task_t*>(context))(index);
+		}, &task, false);
+	}
+
+	// like run(), but every thread starts with a contiguous share of the
+	// tasks and steals half of another thread's remaining ones when it
+	// runs out, for tasks of very different cost
+	template <class Task>
+	void run_stealing(int tasks, Task&& task) {
+		using task_t = std::remove_reference_t<Task>;
+		run_tasks(tasks, [](void* context, int index) {
+			(*static_cast<task_t*>(context))(index);
+		}, &task, true);
+	}
+
+	const std::vector<Stats>& stats() const {
+		return m_stats;
+	}
+	// time spent in run() and run_stealing()
+	std::chrono::nanoseconds run_time() const {
+		return m_run_time;
+	}
+	void reset_stats();
+
+private:
+	using task_fn_t = void (*)(void* context, int index);
+
+	// tasks [begin, end) left to a thread, the owner takes them from the
+	// end, thieves from the beginning
+	struct alignas(64) TaskRange {
+		std::mutex mutex;
+		int begin = 0;
+		int end = 0;
+	};
+
+	void run_tasks(int tasks, task_fn_t function, void* context,
+			bool stealing);
+	// thread is the index of the calling thread
+	void work(int thread);
+	void work_stealing(int thread);
+	bool steal(int thread);
+	void run_task(int thread, int index);
+	void worker_loop(int thread);
+
+	std::vector<std::thread> m_workers;
+	std::mutex m_mutex;
+	std::condition_variable m_start;
+	std::condition_variable m_done;
+	unsigned long m_generation = 0;
+	int m_running = 0;
+	bool m_stop = false;
+
+	std::atomic<int> m_next_task{0};
+	int m_tasks = 0;
+	task_fn_t m_function = nullptr;
+	void* m_context = nullptr;
+	bool m_stealing = false;
+	std::unique_ptr<TaskRange[]> m_ranges;
+
+	// each thread writes only its own
+	std::vector<Stats> m_stats;
+	std::chrono::nanoseconds m_run_time{0};
+};
+
+#endif // THREAD_POOL_HPP
@@ -0,0 +1,91 @@
+#ifndef TOPOLOGY_HPP
+#define TOPOLOGY_HPP
+
+#include <optional>
+#include <string>
+
+#include "bit_grid.hpp"
+
+// how the edges of a finite board are glued together
+enum class Topology {
+	// cells beyond the edges are dead
+	plane,
+	torus,
+	// columns wrap, rows wrap mirrored left to right
+	klein,
+	// cross surface, both directions wrap mirrored
+	cross,
+};
+
+// Policies map a cell outside the board onto the one it stands for and
+// return false if it is dead. Edge handling lives here and in the halo
+// they fill, so the kernels need none.
+struct PlaneTopology {
+	static bool map(int&, int&, int, int) {
+		return false;
+	}
+};
+
+struct TorusTopology {
+	static bool map(int& row, int& col, int height, int width) {
+		row = wrap(row, height);
+		col = wrap(col, width);
+		return true;
+	}
+
+	// [0, size) and whether it went around an odd number of times
+	static int wrap(int index, int size, bool* odd = nullptr) {
+		auto turns = index >= 0 ? index / size : (index + 1) / size - 1;
+		if (odd)
+			*odd = turns & 1;
+		return index - turns * size;
+	}
+};
+
+struct KleinTopology {
+	static bool map(int& row, int& col, int height, int width) {
+		bool mirrored;
+		row = TorusTopology::wrap(row, height, &mirrored);
+		col = TorusTopology::wrap(col, width);
+		if (mirrored)
+			col = width - 1 - col;
+		return true;
+	}
+};
+
+struct CrossTopology {
+	static bool map(int& row, int& col, int height, int width) {
+		bool mirror_cols, mirror_rows;
+		row = TorusTopology::wrap(row, height, &mirror_cols);
+		col = TorusTopology::wrap(col, width, &mirror_rows);
+		if (mirror_cols)
+			col = width - 1 - col;
+		if (mirror_rows)
+			row = height - 1 - row;
+		return true;
+	}
+};
+
+// calls function with the policy of topology
+template <class Function>
+decltype(auto) with_topology(Topology topology, Function&& function) {
+	switch (topology) {
+	case Topology::torus:
+		return function(TorusTopology());
+	case Topology::klein:
+		return function(KleinTopology());
+	case Topology::cross:
+		return function(CrossTopology());
+	default:
+		return function(PlaneTopology());
+	}
+}
+
+// fills the one cell halo of grid with the cells across the edges, before
+// each generation as the kernels write only the board
+void fill_halo(BitGrid& grid, Topology topology);
+
+const char* topology_name(Topology topology);
+std::optional<Topology> topology_from_name(const std::string& name);
+
+#endif // TOPOLOGY_HPP
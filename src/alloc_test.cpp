@@ -0,0 +1,95 @@
+#include <clocale>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+
+#include "allocation_counter.hpp"
+#include "board.hpp"
+#include "density_pyramid.hpp"
+
+// Steps every engine that keeps its generations in fixed buffers, on the
+// plane and the torus, with and without worker threads, and fails if a
+// warmed up iteration allocates anything. Every iteration also does what
+// the renderers do with a generation: a density pyramid update, and with
+// damage tracking the changed characters drawn to an ncurses pad.
+
+static constexpr int side = 256;
+static constexpr int warmup = 20;
+static constexpr int generations = 1000;
+// characters of a typical terminal
+static constexpr int pad_rows = 50;
+static constexpr int pad_cols = 160;
+
+// one generation and everything drawing it reads
+static void step(Board& board, DensityPyramid& pyramid, WINDOW* pad,
+		bool damage, int generation) {
+	board.iterate();
+	// readers make the morton engine fill the ring
+	pyramid.update(board.generation(0));
+	if (!damage)
+		return;
+	if (pad)
+		board.draw_damage(pad, 0, 0,
+				static_cast<Board::Glyphs>(generation % 3));
+	board.clear_damage();
+}
+
+// false if a measured generation allocates
+static bool run(Board::Algorithm algorithm, Topology topology, int threads,
+		bool damage, WINDOW* pad) {
+	Board board(side, side);
+	board.set_threads(threads);
+	board.set_topology(topology);
+	board.set_damage_tracking(damage);
+	std::cout << algorithm_name(algorithm) << ' ' <<
+		topology_name(topology) << ' ' << threads << " threads" <<
+		(damage ? " damage" : "") << ": ";
+	if (!board.set_algorithm(algorithm)) {
+		std::cout << "not supported\n";
+		return true;
+	}
+	std::mt19937 random(1);
+	for (int i = 0; i < side * side / 3; ++i)
+		board.add_at(random() % side, random() % side);
+	DensityPyramid pyramid(side, side);
+
+	for (int i = 0; i < warmup; ++i)
+		step(board, pyramid, pad, damage, i);
+	auto before = allocation_count();
+	for (int i = 0; i < generations; ++i)
+		step(board, pyramid, pad, damage, i);
+	auto allocations = allocation_count() - before;
+	std::cout << allocations << " allocations\n";
+	return !allocations;
+}
+
+int main() {
+	// a terminal writing to nowhere, so the test needs none; without the
+	// terminal description nothing is drawn
+	std::setlocale(LC_ALL, "");
+	auto null_out = std::fopen("/dev/null", "w");
+	auto null_in = std::fopen("/dev/null", "r");
+	auto screen = null_out && null_in ?
+		newterm("xterm", null_out, null_in) : nullptr;
+	auto pad = screen ? newpad(pad_rows, pad_cols) : nullptr;
+	if (!pad)
+		std::cout << "no terminal, damage is not drawn\n";
+
+	int failures = 0;
+	for (auto algorithm : { Board::Algorithm::dense, Board::Algorithm::sparse,
+			Board::Algorithm::tiled, Board::Algorithm::morton })
+		for (auto topology : { Topology::plane, Topology::torus })
+			for (int threads : { 1, 4 })
+				for (bool damage : { false, true })
+					if (!run(algorithm, topology, threads, damage, pad))
+						++failures;
+
+	if (pad)
+		delwin(pad);
+	if (screen) {
+		endwin();
+		delscreen(screen);
+	}
+	return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
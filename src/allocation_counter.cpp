@@ -0,0 +1,50 @@
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#include "allocation_counter.hpp"
+
+// every heap allocation of the process; the deletes stay out of line, so
+// the compiler does not pair inlined free() calls with new
+static std::atomic<unsigned long> allocations{0};
+
+unsigned long allocation_count() {
+	return allocations.load(std::memory_order_relaxed);
+}
+
+void* operator new(std::size_t size) {
+	allocations.fetch_add(1, std::memory_order_relaxed);
+	if (auto result = std::malloc(size ? size : 1))
+		return result;
+	throw std::bad_alloc();
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment) {
+	allocations.fetch_add(1, std::memory_order_relaxed);
+	auto align = static_cast<std::size_t>(alignment);
+	if (auto result = std::aligned_alloc(align,
+			(std::max<std::size_t>(size, 1) + align - 1) / align * align))
+		return result;
+	throw std::bad_alloc();
+}
+
+__attribute__((noinline))
+void operator delete(void* pointer) noexcept {
+	std::free(pointer);
+}
+
+__attribute__((noinline))
+void operator delete(void* pointer, std::size_t) noexcept {
+	std::free(pointer);
+}
+
+__attribute__((noinline))
+void operator delete(void* pointer, std::align_val_t) noexcept {
+	std::free(pointer);
+}
+
+__attribute__((noinline))
+void operator delete(void* pointer, std::size_t, std::align_val_t) noexcept {
+	std::free(pointer);
+}
@@ -0,0 +1,228 @@
+#include <sys/resource.h>
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+#include <boost/program_options.hpp>
+
+#include "allocation_counter.hpp"
+#include "board.hpp"
+#include "grid_storage.hpp"
+#include "rtl_parser.hpp"
+
+namespace po = boost::program_options;
+
+// Runs every pattern of the corpus on every board size with every engine
+// for a fixed time and prints the results as JSON. Patterns start in the
+// middle of an empty square board with the plane topology, under the
+// rule their file gives.
+
+static const std::vector<std::string> corpus = {
+	"gosper_gun", "r_pentomino", "acorn",
+	"soup_15", "soup_35", "soup_50", "switch_engine", "spacefiller",
+};
+
+struct Settings {
+	Kernel kernel;
+	int threads;
+	int warmup;
+	double seconds;
+};
+
+struct Result {
+	long iterations;
+	std::uint64_t generations;
+	double seconds;
+	// KiB, board construction included
+	long peak_rss;
+	// in the timed iterations
+	unsigned long allocations;
+};
+
+// peak resident set of the process starts over from the current one,
+// where the kernel supports it
+static void reset_peak_rss() {
+	std::ofstream clear_refs("/proc/self/clear_refs");
+	clear_refs << "5";
+}
+
+// KiB
+static long peak_rss() {
+	std::ifstream status("/proc/self/status");
+	std::string line;
+	while (std::getline(status, line))
+		if (line.compare(0, 6, "VmHWM:") == 0)
+			return std::stol(line.substr(6));
+	rusage usage;
+	getrusage(RUSAGE_SELF, &usage);
+	return usage.ru_maxrss;
+}
+
+static std::optional<Result> run(Board& pattern, int size,
+		Board::Algorithm algorithm, const Settings& settings) {
+	// memory the previous run freed would still count as resident
+	GridStorage::instance().trim();
+#ifdef __GLIBC__
+	malloc_trim(0);
+#endif
+	reset_peak_rss();
+
+	Board board(size, size);
+	board.set_rules(pattern);
+	board.set_kernel(settings.kernel);
+	board.set_threads(settings.threads);
+	if (!board.set_algorithm(algorithm))
+		return { };
+	auto top = (size - pattern.height()) / 2;
+	auto left = (size - pattern.width()) / 2;
+	for (auto iter = pattern.begin(); iter != pattern.end(); ++iter)
+		if (*iter)
+			board.add_at(top + iter.row, left + iter.col);
+
+	for (int i = 0; i < settings.warmup; ++i)
+		board.iterate();
+
+	Result result = { };
+	auto allocations = allocation_count();
+	auto start = std::chrono::steady_clock::now();
+	std::chrono::duration<double> elapsed(0);
+	do {
+		board.iterate();
+		++result.iterations;
+		elapsed = std::chrono::steady_clock::now() - start;
+	} while (elapsed.count() < settings.seconds);
+
+	result.allocations = allocation_count() - allocations;
+	result.seconds = elapsed.count();
+	result.generations =
+		board.generations_per_iteration() * result.iterations;
+	result.peak_rss = peak_rss();
+	return result;
+}
+
+int main(int argc, char* argv[]) {
+	po::options_description desc("Allowed options");
+	desc.add_options()
+		("help", "print this text")
+		("patterns", po::value<std::string>()->default_value(
+				GAME_OF_LIFE_PATTERNS), "directory of the pattern corpus")
+		("pattern", po::value<std::vector<std::string>>()->multitoken(),
+			"patterns to run (default all)")
+		("size", po::value<std::vector<int>>()->multitoken(),
+			"sides of the square boards (default 256 1024 4096)")
+		("engine", po::value<std::vector<std::string>>()->multitoken(),
+			"engines to run (default all)")
+		("kernel", po::value<std::string>()->default_value("auto"),
+			"life kernel: scalar|sse2|avx2|avx512|auto")
+		("threads", po::value<int>()->default_value(1),
+			"number of threads computing generations (0 - all cores)")
+		("warmup", po::value<int>()->default_value(10),
+			"untimed iterations before each measurement")
+		("seconds", po::value<double>()->default_value(1.0),
+			"time spent on each measurement")
+		("output,o", po::value<std::string>(),
+			"file the JSON goes to (default stdout)")
+		;
+
+	po::variables_map vm;
+	po::store(po::parse_command_line(argc, argv, desc), vm);
+	po::notify(vm);
+
+	if (vm.count("help")) {
+		std::cout << desc << '\n';
+		return EXIT_SUCCESS;
+	}
+
+	Settings settings;
+	auto kernel = kernel_from_name(vm["kernel"].as<std::string>());
+	if (!kernel || !kernel_supported(*kernel)) {
+		std::cerr << "Kernel " << vm["kernel"].as<std::string>() <<
+			" is unknown or not supported by this cpu\n";
+		return EXIT_FAILURE;
+	}
+	settings.kernel = *kernel == Kernel::automatic ? best_kernel() : *kernel;
+	settings.threads = vm["threads"].as<int>();
+	if (settings.threads == 0)
+		settings.threads = std::thread::hardware_concurrency();
+	settings.warmup = vm["warmup"].as<int>();
+	settings.seconds = vm["seconds"].as<double>();
+
+	auto patterns = corpus;
+	if (vm.count("pattern"))
+		patterns = vm["pattern"].as<std::vector<std::string>>();
+	std::vector<int> sizes = { 256, 1024, 4096 };
+	if (vm.count("size"))
+		sizes = vm["size"].as<std::vector<int>>();
+	std::vector<Board::Algorithm> algorithms = {
+		Board::Algorithm::dense, Board::Algorithm::sparse,
+		Board::Algorithm::tiled, Board::Algorithm::morton,
+		Board::Algorithm::hashlife, Board::Algorithm::unbounded,
+	};
+	if (vm.count("engine")) {
+		algorithms.clear();
+		for (auto&& name : vm["engine"].as<std::vector<std::string>>()) {
+			auto algorithm = algorithm_from_name(name);
+			if (!algorithm) {
+				std::cerr << "Unknown engine " << name << '\n';
+				return EXIT_FAILURE;
+			}
+			algorithms.push_back(*algorithm);
+		}
+	}
+
+	std::ofstream file;
+	if (vm.count("output"))
+		file.open(vm["output"].as<std::string>());
+	std::ostream& out = vm.count("output") ? file : std::cout;
+
+	out << "{\n";
+	out << "  \"build_type\": \"" << GAME_OF_LIFE_BUILD_TYPE << "\",\n";
+	out << "  \"compiler\": \"" << GAME_OF_LIFE_COMPILER << "\",\n";
+	out << "  \"cxx_flags\": \"" << GAME_OF_LIFE_CXX_FLAGS << "\",\n";
+	out << "  \"kernel\": \"" << kernel_name(settings.kernel) << "\",\n";
+	out << "  \"threads\": " << settings.threads << ",\n";
+	out << "  \"seconds\": " << settings.seconds << ",\n";
+	out << "  \"results\": [";
+	bool first = true;
+	for (auto&& name : patterns) {
+		auto pattern = parse_from_file(
+				vm["patterns"].as<std::string>() + '/' + name + ".rtl");
+		if (!pattern) {
+			std::cerr << "Cannot read pattern " << name << '\n';
+			return EXIT_FAILURE;
+		}
+		for (auto size : sizes) {
+			for (auto algorithm : algorithms) {
+				std::cerr << name << ' ' << size << ' ' <<
+					algorithm_name(algorithm) << '\n';
+				auto result = run(*pattern, size, algorithm, settings);
+				if (!result)
+					continue;
+
+				auto per_second = result->generations / result->seconds;
+				out << (first ? "\n" : ",\n");
+				first = false;
+				out << "    {\"pattern\": \"" << name << "\", " <<
+					"\"engine\": \"" << algorithm_name(algorithm) << "\", " <<
+					"\"width\": " << size << ", " <<
+					"\"height\": " << size << ", " <<
+					"\"iterations\": " << result->iterations << ", " <<
+					"\"generations\": " << result->generations << ", " <<
+					"\"seconds\": " << result->seconds << ", " <<
+					"\"generations_per_second\": " << per_second << ", " <<
+					"\"cells_per_second\": " <<
+						per_second * size * size << ", " <<
+					"\"peak_rss_kib\": " << result->peak_rss << ", " <<
+					"\"allocations\": " << result->allocations << "}";
+			}
+		}
+	}
+	out << "\n  ]\n}\n";
+}
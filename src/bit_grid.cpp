@@ -0,0 +1,27 @@
+#include <algorithm>
+
+#include "bit_grid.hpp"
+
+BitGrid::BitGrid(int height, int width) :
+		m_width(width), m_height(height) {
+	m_last_word = (std::max(width, 1) - 1) / word_bits + 1;
+	m_stride = (m_last_word + 1 + simd_words) / simd_words * simd_words;
+	auto tail_bits = width - (m_last_word - 1) * word_bits;
+	m_tail_mask = tail_bits == word_bits ?
+		~word_t(0) : (word_t(1) << tail_bits) - 1;
+	m_words = GridBuffer<word_t>(static_cast<std::size_t>(m_height + 2) * m_stride);
+	m_words.fill_zero();
+}
+
+void BitGrid::wrap_halo() {
+	if (!m_width || !m_height)
+		return;
+	for (int r = 0; r < m_height; ++r) {
+		set(r, -1, get(r, m_width - 1));
+		set(r, m_width, get(r, 0));
+	}
+	// whole rows, so corners come with the side columns
+	std::copy(row(m_height - 1), row(m_height), row(-1));
+	std::copy(row(0), row(1), row(m_height));
+}
+
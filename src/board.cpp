@@ -1,150 +1,854 @@
 #include <curses.h>
+#include <unistd.h>
 #include <algorithm>
+#include <charconv>
+#include <string_view>
 
 #include <iostream>
 #include <fstream>
 
-#include <SFML/Graphics.hpp>
-
 #include "board.hpp"
 
-// #define BOARD_OVERLAP
+Board::Board(int height, int width) : m_width(width), m_height(height),
+		m_history(2, board_array_t(height, width)), m_current(0), m_past(0),
+		m_rule{ 1u << 3, 1u << 2 | 1u << 3 }, m_kernel_choice(Kernel::automatic),
+		m_kernel(life_kernel(m_kernel_choice, m_rule)),
+		m_tile_kernel(life_tile_kernel(m_kernel_choice, m_rule)),
+		m_algorithm(Algorithm::dense), m_topology(Topology::plane),
+		m_tiles_x(0), m_tiles_y(0), m_tile_rows(0), m_tile_words(0),
+		m_tile_generations(1),
+		m_morton_steps(0), m_step_log(0),
+		m_damage_tracking(false), m_damaged(false) {
+	set_tile_size(0);
+	m_sums.resize(1);
+}
+
+void Board::set_rules(const std::set<int>& survives, const std::set<int>& born) {
+	m_rule = { 0, 0 };
+	for (auto&& iter : born)
+		m_rule.born |= 1u << iter;
+	for (auto&& iter : survives)
+		m_rule.survives |= 1u << iter;
+
+	m_isotropic.reset();
+	m_range_rule.reset();
+	mark_all_changed();
+	m_kernel = life_kernel(m_kernel_choice, m_rule);
+	m_tile_kernel = life_tile_kernel(m_kernel_choice, m_rule);
+	if (m_hashlife)
+		m_hashlife->set_rule(m_rule);
+	if (m_chunked)
+		m_chunked->set_rule(m_rule);
+}
+
+void Board::set_rules(const IsotropicRule& rule) {
+	// the universes only know totalistic rules
+	if (m_hashlife || m_chunked || !m_morton.empty())
+		set_algorithm(Algorithm::dense);
+	mark_all_changed();
+	m_range_rule.reset();
+	m_isotropic = rule;
+}
+
+void Board::set_rules(const LargerThanLifeRule& rule) {
+	if (m_hashlife || m_chunked || !m_morton.empty())
+		set_algorithm(Algorithm::dense);
+	mark_all_changed();
+	m_isotropic.reset();
+	m_range_rule = rule;
+}
+
+void Board::set_rules(const Board& other) {
+	if (other.m_range_rule)
+		set_rules(*other.m_range_rule);
+	else if (other.m_isotropic)
+		set_rules(*other.m_isotropic);
+	else {
+		std::set<int> survives, born;
+		for (int count = 0; count <= 8; ++count) {
+			if (other.m_rule.survives >> count & 1)
+				survives.insert(count);
+			if (other.m_rule.born >> count & 1)
+				born.insert(count);
+		}
+		set_rules(survives, born);
+	}
+}
+
+bool Board::set_topology(Topology topology) {
+	if (topology != Topology::plane &&
+			(m_hashlife || m_chunked || !m_morton.empty()))
+		return false;
+	m_topology = topology;
+	mark_all_changed();
+	return true;
+}
+
+bool Board::set_kernel(Kernel kernel) {
+	auto result = life_kernel(kernel, m_rule);
+	if (!result)
+		return false;
+	m_kernel_choice = kernel;
+	m_kernel = result;
+	m_tile_kernel = life_tile_kernel(kernel, m_rule);
+	return true;
+}
+
+void Board::set_threads(int threads) {
+	if (threads > 1)
+		m_pool = std::make_shared<ThreadPool>(threads);
+	else
+		m_pool.reset();
+	m_sums.resize(m_pool ? m_pool->size() : 1);
+}
+
+bool Board::set_algorithm(Algorithm algorithm) {
+	sync_morton();
+	m_hashlife.reset();
+	m_chunked.reset();
+	m_morton.clear();
+	if (algorithm == Algorithm::morton) {
+		// tiles have no halo for other edges, the tile step knows only
+		// totalistic rules
+		if (m_topology != Topology::plane || m_isotropic || m_range_rule)
+			return false;
+		m_morton.assign(2, MortonGrid(m_height, m_width));
+		m_morton[0].load(current());
+	}
+	if (algorithm == Algorithm::hashlife ||
+			algorithm == Algorithm::unbounded) {
+		// births from nothing would fill the infinite plane
+		if (m_topology != Topology::plane ||
+				m_isotropic || m_range_rule || m_rule.born & 1)
+			return false;
+		if (algorithm == Algorithm::hashlife)
+			m_hashlife.emplace(m_rule);
+		else
+			m_chunked.emplace(m_rule);
+		for (auto iter = begin(); iter != end(); ++iter) {
+			if (!*iter)
+				continue;
+			if (m_hashlife)
+				m_hashlife->set(iter.row, iter.col, true);
+			else
+				m_chunked->set(iter.row, iter.col, true);
+		}
+	}
+
+	if (algorithm == Algorithm::sparse) {
+		// everything counts as changed in the first generation
+		m_tiles_x = (current().last_word() + sparse_tile_words - 1) /
+			sparse_tile_words;
+		m_tiles_y = (m_height + sparse_tile_rows - 1) / sparse_tile_rows;
+		m_tile_changed.assign(m_tiles_x * m_tiles_y, true);
+		m_next_tile_changed = m_tile_changed;
+	}
+	else {
+		m_tile_changed.clear();
+		m_next_tile_changed.clear();
+	}
 
-Board::Board(int height, int width) : m_width(width), m_height(height){
-	m_board.resize(m_height);
+	m_algorithm = algorithm;
+	return true;
+}
 
-	for (auto&& iter : m_board)
-		iter.resize(m_width);
+void Board::set_tile_size(int cells) {
+	if (cells > 0) {
+		m_tile_words = std::max(cells / BitGrid::word_bits, 1);
+		m_tile_rows = m_tile_words * BitGrid::word_bits;
+		return;
+	}
 
-	m_temporary_board = m_board;
-	m_survives.insert({2, 3});
-	m_born.insert(3);
+	// Square tiles are only a few hundred bytes wide in bits, and strided
+	// short rows keep the prefetcher from streaming them. Rows up to a page
+	// wide instead, as many as fit src and dst in half the cache.
+	long cache = ::sysconf(_SC_LEVEL2_CACHE_SIZE);
+	if (cache <= 0)
+		cache = 256 * 1024;
+	constexpr int page_words = 4096 / sizeof(BitGrid::word_t);
+	m_tile_words = std::min(current().last_word(), page_words);
+	auto row_bytes = m_tile_words * sizeof(BitGrid::word_t);
+	m_tile_rows = std::max(static_cast<int>(cache / 4 / row_bytes),
+			BitGrid::word_bits);
+}
 
-	// m_board[5][5] = true;
-	// m_board[5][6] = true;
-	// m_board[6][6] = true;
-	// m_board[7][7] = true;
+void Board::set_history(int generations) {
+	auto board = std::move(current());
+	m_history.assign(std::max(generations, 1) + 1, board_array_t());
+	m_history[0] = std::move(board);
+	for (std::size_t i = 1; i < m_history.size(); ++i)
+		m_history[i] = board_array_t(m_height, m_width);
+	m_current = 0;
+	m_past = 0;
+	mark_all_changed();
+	mark_all_damaged();
+}
+
+const Board::board_array_t& Board::generation(int generations_ago) const {
+	sync_morton();
+	auto size = static_cast<int>(m_history.size());
+	return m_history[(m_current - generations_ago % size + size) % size];
+}
+
+bool Board::rewind() {
+	sync_morton();
+	if (!m_past || m_hashlife || m_chunked)
+		return false;
+	auto size = static_cast<int>(m_history.size());
+	m_current = (m_current + size - 1) % size;
+	--m_past;
+	if (!m_morton.empty())
+		m_morton[0].load(current());
+	// change flags describe the generation that was dropped
+	mark_all_changed();
+	mark_all_damaged();
+	return true;
+}
+
+void Board::advance() {
+	m_current = (m_current + 1) % m_history.size();
+	m_past = std::min(m_past + 1, static_cast<int>(m_history.size()) - 1);
+	find_damage();
 }
 
 void Board::iterate() {
-	auto count_neighbours = [&](auto row, auto col) {
-#ifdef BOARD_OVERLAP
-		auto mod = [](int a, int b) {
-			return a < 0 ? a + b : a % b;
-		};
-		int result = 0;
-		for (auto row_iter = row - 1;
-				row_iter < row + 2; ++row_iter) {
-			for (auto col_iter = col - 1;
-					col_iter < col + 2; ++col_iter) {
-				if (row_iter == row && col_iter == col)
-					continue;
-				if (m_board[mod(row_iter ,m_height)][mod(col_iter, m_width)])
-					++result;
+	if (m_hashlife) {
+		m_hashlife->step(m_step_log);
+		m_hashlife->render(next(), 0, 0);
+		advance();
+		return;
+	}
+	if (m_chunked) {
+		m_chunked->step();
+		m_chunked->render(next(), 0, 0);
+		advance();
+		return;
+	}
+	if (!m_morton.empty()) {
+		iterate_morton(m_rule);
+		return;
+	}
+
+	auto rule = m_rule;
+	auto& board = current();
+	auto& next_board = next();
+
+	if (temporal_blocking()) {
+		iterate_temporal(rule, m_tile_generations);
+		advance();
+		return;
+	}
+
+	fill_halo(board, m_topology);
+
+	if (m_algorithm == Algorithm::sparse)
+		iterate_sparse(rule);
+	else if (m_algorithm == Algorithm::tiled)
+		iterate_tiled(rule);
+	else if (m_pool) {
+		auto bands = m_pool->size();
+		m_pool->run(bands, [&](int band) {
+			step_rect(board, next_board,
+					m_height * band / bands,
+					m_height * (band + 1) / bands,
+					1, board.last_word() + 1, rule);
+		});
+	}
+	else
+		step_rect(board, next_board, 0, m_height,
+				1, board.last_word() + 1, rule);
+
+	advance();
+}
+
+std::uint64_t Board::generations_per_iteration() const {
+	if (m_hashlife)
+		return std::uint64_t(1) <<
+			std::clamp(m_step_log, 0, HashLife::max_step_log);
+	if (temporal_blocking())
+		return m_tile_generations;
+	return 1;
+}
+
+bool Board::temporal_blocking() const {
+	return m_algorithm == Algorithm::tiled && m_tile_generations > 1 &&
+		!m_range_rule && (m_topology == Topology::plane ||
+			m_topology == Topology::torus);
+}
+
+// Square tiles small enough for the cache, so the rows above and below
+// are still there when the next row reads them. Tiles read the borders of
+// their neighbours straight from the current generation, which nobody
+// writes, and the board's own border from the halo.
+void Board::iterate_tiled(RuleMasks rule) {
+	auto& board = current();
+	auto& next_board = next();
+	auto tiles_x = (board.last_word() + m_tile_words - 1) / m_tile_words;
+	auto tiles_y = (m_height + m_tile_rows - 1) / m_tile_rows;
+
+	auto step_tile = [&](int tile) {
+		auto row_begin = tile / tiles_x * m_tile_rows;
+		auto word_begin = 1 + tile % tiles_x * m_tile_words;
+		step_rect(board, next_board,
+				row_begin, std::min(m_height, row_begin + m_tile_rows),
+				word_begin, std::min(board.last_word() + 1,
+					word_begin + m_tile_words),
+				rule);
+	};
+
+	if (m_pool)
+		m_pool->run_stealing(tiles_x * tiles_y, step_tile);
+	else
+		for (int tile = 0; tile < tiles_x * tiles_y; ++tile)
+			step_tile(tile);
+}
+
+// Every tile is copied with a halo as wide as the number of generations
+// into a buffer of its thread and stepped there. Cells near the edge of
+// the buffer go wrong from its missing neighbours, one more cell each
+// generation, so the tile itself stays exact. The halo wraps around on a
+// torus; on a plane cells beyond the board are cleared after each step.
+void Board::iterate_temporal(RuleMasks rule, int generations) {
+	auto& board = current();
+	auto& next_board = next();
+	auto last = board.last_word();
+	bool torus = m_topology == Topology::torus;
+	auto tiles_x = (last + m_tile_words - 1) / m_tile_words;
+	auto tiles_y = (m_height + m_tile_rows - 1) / m_tile_rows;
+	auto halo_rows = generations;
+	auto halo_words = (generations + BitGrid::word_bits - 1) / BitGrid::word_bits;
+
+	auto threads = m_pool ? m_pool->size() : 1;
+	auto buffer_rows = m_tile_rows + 2 * halo_rows;
+	auto buffer_width = (m_tile_words + 2 * halo_words) * BitGrid::word_bits;
+	if (static_cast<int>(m_tile_buffers.size()) != 2 * threads ||
+			m_tile_buffers[0].height() != buffer_rows ||
+			m_tile_buffers[0].width() != buffer_width)
+		m_tile_buffers.assign(2 * threads,
+				board_array_t(buffer_rows, buffer_width));
+
+	auto step_tile = [&](int tile) {
+		auto row_begin = tile / tiles_x * m_tile_rows;
+		auto row_end = std::min(m_height, row_begin + m_tile_rows);
+		auto word_begin = 1 + tile % tiles_x * m_tile_words;
+		auto word_end = std::min(last + 1, word_begin + m_tile_words);
+		// buffer row 0 and word 1 are board row top and word left
+		auto top = row_begin - halo_rows;
+		auto left = word_begin - halo_words;
+		auto rows = row_end - row_begin + 2 * halo_rows;
+		auto words = word_end - word_begin + 2 * halo_words;
+
+		// whole halo on the board, nothing to wrap or clear
+		bool inside = top >= 0 && top + rows <= m_height && left >= 1 &&
+			(left + words - 1) * BitGrid::word_bits <= m_width;
+
+		// buffer words of board words 1 and last
+		auto first_word = std::max(1, 2 - left);
+		auto last_word = last - left + 1;
+
+		auto buffer = &m_tile_buffers[2 * ThreadPool::thread_index()];
+		auto other = buffer + 1;
+		for (int row = 0; row < rows && inside; ++row)
+			std::copy(board.row(top + row) + left,
+					board.row(top + row) + left + words, buffer->row(row) + 1);
+		for (int row = 0; row < rows && !inside; ++row) {
+			int board_row = top + row;
+			bool outside = board_row < 0 || board_row >= m_height;
+			if (torus)
+				board_row = TorusTopology::wrap(board_row, m_height);
+			auto in = board.row(board_row);
+			auto out = buffer->row(row);
+			for (int word = 1; word <= words; ++word) {
+				int board_word = left + word - 1;
+				int col = (board_word - 1) * BitGrid::word_bits;
+				if (!torus && outside)
+					out[word] = 0;
+				else if (col >= 0 && col + BitGrid::word_bits <= m_width)
+					out[word] = in[board_word];
+				else if (!torus)
+					out[word] = board_word == last ?
+						in[board_word] & board.tail_mask() : 0;
+				else {
+					// columns wrapped one by one
+					BitGrid::word_t value = 0;
+					for (int bit = 0; bit < BitGrid::word_bits; ++bit)
+						value |= BitGrid::word_t(board.get(board_row,
+								TorusTopology::wrap(col + bit, m_width))) << bit;
+					out[word] = value;
+				}
 			}
 		}
-		return result;
-#else
-		int result = 0;
-		for (auto row_iter = std::max(1, row) - 1;
-				row_iter < std::min(row + 2, m_height); ++row_iter) {
-			for (auto col_iter = std::max(1, col) - 1;
-					col_iter < std::min(col + 2, m_width); ++col_iter) {
-				if (row_iter == row && col_iter == col)
+
+		for (int generation = 0; generation < generations; ++generation) {
+			step_rect(*buffer, *other, 0, rows, 1, words + 1, rule);
+			std::swap(buffer, other);
+			if (torus || inside)
+				continue;
+			for (int row = 0; row < rows; ++row) {
+				auto out = buffer->row(row);
+				if (top + row < 0 || top + row >= m_height) {
+					std::fill(out + 1, out + words + 1, 0);
 					continue;
-				if (m_board[row_iter][col_iter])
-					++result;
+				}
+				std::fill(out + 1, out + first_word, 0);
+				if (last_word <= words) {
+					out[last_word] &= board.tail_mask();
+					std::fill(out + last_word + 1, out + words + 1, 0);
+				}
 			}
 		}
-		return result;
-#endif // BOARD_OVERLAP
+
+		for (int row = row_begin; row < row_end; ++row) {
+			auto in = buffer->row(row - top);
+			auto out = next_board.row(row);
+			for (int word = word_begin; word < word_end; ++word)
+				out[word] = in[word - left + 1];
+			if (word_end == last + 1)
+				out[last] &= board.tail_mask();
+		}
 	};
 
+	if (m_pool)
+		m_pool->run_stealing(tiles_x * tiles_y, step_tile);
+	else
+		for (int tile = 0; tile < tiles_x * tiles_y; ++tile)
+			step_tile(tile);
+}
 
-	for (int row = 0; row < m_height; ++row) {
-		for (int col = 0; col < m_width; ++col) {
-			auto neighbours_no = count_neighbours(row, col);
-			if (m_board[row][col]) {
-				if (m_survives.count(neighbours_no))
-					m_temporary_board[row][col] = true;
-				else
-					m_temporary_board[row][col] = false;
-			}
-			else {
-				if (m_born.count(neighbours_no))
-					m_temporary_board[row][col] = true;
-				else
-					m_temporary_board[row][col] = false;
+// Slots next to each other are close on the board too, so the contiguous
+// ranges the scheduler hands out are compact blocks of tiles. The result
+// is copied to the row major ring only when the board is read, unless
+// every generation is needed there: for damage or a longer history.
+void Board::iterate_morton(RuleMasks rule) {
+	auto& src = m_morton[0];
+	auto& dst = m_morton[1];
+	auto step_slot = [&](int slot) {
+		life_step_slot(src, dst, slot, m_tile_kernel, rule);
+	};
+	if (m_pool)
+		m_pool->run_stealing(src.tile_count(), step_slot);
+	else
+		for (int slot = 0; slot < src.tile_count(); ++slot)
+			step_slot(slot);
+	std::swap(src, dst);
+	if (m_damage_tracking || m_history.size() > 2) {
+		src.store(next());
+		advance();
+	}
+	else
+		++m_morton_steps;
+}
+
+// The ring has two generations then. The one before the current is
+// m_morton[1], and unless it is only one step behind, the ring's current
+// generation is older than that.
+void Board::sync_morton() const {
+	if (!m_morton_steps)
+		return;
+	auto size = static_cast<int>(m_history.size());
+	if (m_morton_steps > 1)
+		m_morton[1].store(m_history[m_current]);
+	m_current = (m_current + 1) % size;
+	m_morton[0].store(m_history[m_current]);
+	m_past = std::min(m_past + 1, size - 1);
+	m_morton_steps = 0;
+}
+
+// Only tiles next to a tile that changed in the last generation can
+// change. The others are skipped: with two buffers the next one holds the
+// previous generation, which equals the current one for such tiles.
+// A longer history has to copy them.
+void Board::iterate_sparse(RuleMasks rule) {
+	auto& board = current();
+	auto& next_board = next();
+	bool copy_skipped = m_history.size() > 2;
+
+	// Changes near an edge reach across it. The tiles there do not line up
+	// with the ones across (mirrored or short edge tiles), so any such
+	// change wakes every tile near an edge.
+	auto reach = m_range_rule ? m_range_rule->range : 1;
+	auto near_edge = [&](int tile_y, int tile_x) {
+		auto row_begin = tile_y * sparse_tile_rows;
+		auto row_end = std::min(m_height, row_begin + sparse_tile_rows);
+		auto col_begin = tile_x * sparse_tile_words * BitGrid::word_bits;
+		auto col_end = std::min(m_width,
+				col_begin + sparse_tile_words * BitGrid::word_bits);
+		return row_begin < reach || row_end > m_height - reach ||
+			col_begin < reach || col_end > m_width - reach;
+	};
+	bool edge_changed = false;
+	if (m_topology != Topology::plane)
+		for (int tile_y = 0; tile_y < m_tiles_y; ++tile_y)
+			for (int tile_x = 0; tile_x < m_tiles_x; ++tile_x)
+				if (near_edge(tile_y, tile_x))
+					edge_changed |= m_tile_changed[tile_y * m_tiles_x + tile_x];
+
+	auto changed_near = [&](int tile_y, int tile_x) {
+		if (edge_changed && near_edge(tile_y, tile_x))
+			return true;
+		for (int y = tile_y - 1; y <= tile_y + 1; ++y) {
+			for (int x = tile_x - 1; x <= tile_x + 1; ++x) {
+				if (y < 0 || y >= m_tiles_y || x < 0 || x >= m_tiles_x)
+					continue;
+				if (m_tile_changed[y * m_tiles_x + x])
+					return true;
 			}
 		}
+		return false;
+	};
+
+	// tiles to step, or to copy with a longer history; the stable rest is
+	// left out of the schedule
+	m_active_tiles.clear();
+	for (int tile = 0; tile < m_tiles_x * m_tiles_y; ++tile) {
+		m_next_tile_changed[tile] = false;
+		if (copy_skipped || changed_near(tile / m_tiles_x, tile % m_tiles_x))
+			m_active_tiles.push_back(tile);
+	}
+
+	auto step_tile = [&](int task) {
+		auto tile = m_active_tiles[task];
+		auto tile_y = tile / m_tiles_x;
+		auto tile_x = tile % m_tiles_x;
+		auto row_begin = tile_y * sparse_tile_rows;
+		auto row_end = std::min(m_height, row_begin + sparse_tile_rows);
+		auto word_begin = 1 + tile_x * sparse_tile_words;
+		auto word_end = std::min(board.last_word() + 1,
+				word_begin + sparse_tile_words);
+		if (!changed_near(tile_y, tile_x)) {
+			for (int row = row_begin; row < row_end; ++row)
+				std::copy(board.row(row) + word_begin,
+						board.row(row) + word_end,
+						next_board.row(row) + word_begin);
+			return;
+		}
+
+		step_rect(board, next_board, row_begin, row_end,
+				word_begin, word_end, rule);
+		bool changed = false;
+		for (int row = row_begin; row < row_end && !changed; ++row)
+			changed = !std::equal(board.row(row) + word_begin,
+					board.row(row) + word_end,
+					next_board.row(row) + word_begin);
+		m_next_tile_changed[tile] = changed;
+	};
+
+	// activity is uneven, so threads steal tiles from each other
+	auto tasks = static_cast<int>(m_active_tiles.size());
+	if (m_pool)
+		m_pool->run_stealing(tasks, step_tile);
+	else
+		for (int task = 0; task < tasks; ++task)
+			step_tile(task);
+
+	std::swap(m_tile_changed, m_next_tile_changed);
+}
+
+void Board::step_rect(const board_array_t& board, board_array_t& next_board,
+		int row_begin, int row_end, int word_begin, int word_end,
+		RuleMasks rule) {
+	if (m_range_rule) {
+		auto& sums = m_sums[ThreadPool::thread_index()];
+		sums.build(board, m_range_rule->range, m_topology,
+				row_begin, row_end, (word_begin - 1) * BitGrid::word_bits,
+				std::min((word_end - 1) * BitGrid::word_bits, m_width));
+		life_step_range(sums, board, next_board, row_begin, row_end,
+				word_begin, word_end, *m_range_rule);
+	}
+	else if (m_isotropic)
+		life_step_table(board, next_board, row_begin, row_end,
+				word_begin, word_end, m_isotropic->next.data());
+	else
+		m_kernel(board, next_board, row_begin, row_end,
+				word_begin, word_end, rule);
+}
+
+void Board::mark_all_changed() {
+	std::fill(m_tile_changed.begin(), m_tile_changed.end(), true);
+}
+
+void Board::mark_changed(int row, int col) {
+	if (m_algorithm != Algorithm::sparse)
+		return;
+	auto tile_x = col / BitGrid::word_bits / sparse_tile_words;
+	m_tile_changed[row / sparse_tile_rows * m_tiles_x + tile_x] = true;
+}
+
+void Board::set_damage_tracking(bool enabled) {
+	sync_morton();
+	m_damage_tracking = enabled;
+	m_damage.clear();
+	m_damaged = false;
+	if (enabled) {
+		m_damage.resize(m_height);
+		mark_all_damaged();
 	}
+}
 
-	m_board = m_temporary_board;
+void Board::clear_damage() {
+	if (!m_damaged)
+		return;
+	std::fill(m_damage.begin(), m_damage.end(), std::pair<int, int>());
+	m_damaged = false;
+}
+
+void Board::add_damage(int row, int col_begin, int col_end) {
+	if (!m_damage_tracking)
+		return;
+	auto& span = m_damage[row];
+	if (span.first < span.second) {
+		span.first = std::min(span.first, col_begin);
+		span.second = std::max(span.second, col_end);
+	}
+	else
+		span = { col_begin, col_end };
+	m_damaged = true;
+}
+
+void Board::mark_all_damaged() {
+	for (int row = 0; row < m_height; ++row)
+		add_damage(row, 0, m_width);
+}
+
+// Reads both generations once more, which is cheap next to stepping, and
+// keeps every algorithm out of it. With temporal blocking or hashlife the
+// generations in between do not matter, only what was shown before.
+void Board::find_damage() {
+	if (!m_damage_tracking)
+		return;
+	auto& board = current();
+	auto& before = generation(1);
+	for (int row = 0; row < m_height; ++row) {
+		auto words = board.row(row);
+		auto before_words = before.row(row);
+		int first = 1;
+		int last = board.last_word();
+		while (first <= last && words[first] == before_words[first])
+			++first;
+		if (first > last)
+			continue;
+		while (words[last] == before_words[last])
+			--last;
+		add_damage(row, (first - 1) * BitGrid::word_bits,
+				std::min(last * BitGrid::word_bits, m_width));
+	}
 }
 
 void Board::add_at(int row, int col) {
-	if (row < m_height && col < m_width)
-		m_board[row][col] = true;
+	if (row < m_height && col < m_width) {
+		current().set(row, col, true);
+		mark_changed(row, col);
+		add_damage(row, col, col + 1);
+		if (m_hashlife)
+			m_hashlife->set(row, col, true);
+		if (m_chunked)
+			m_chunked->set(row, col, true);
+		if (!m_morton.empty())
+			m_morton[0].set(row, col, true);
+	}
 }
 
 void Board::kill_at(int row, int col) {
-	if (row < m_height && col < m_width)
-		m_board[row][col] = false;
+	if (row < m_height && col < m_width) {
+		current().set(row, col, false);
+		mark_changed(row, col);
+		add_damage(row, col, col + 1);
+		if (m_hashlife)
+			m_hashlife->set(row, col, false);
+		if (m_chunked)
+			m_chunked->set(row, col, false);
+		if (!m_morton.empty())
+			m_morton[0].set(row, col, false);
+	}
 }
 
-template<>
-void Board::draw(WINDOW* scr) const {
-	for (int row = 0; row < m_height; ++row) {
-		::wmove(scr, row, 0);
-		for (int col = 0; col < m_width; ++col) {
-			::waddch(scr, m_board[row][col] ? 'X' : ' ');
-		}
-		::waddch(scr, '|');
+const char* algorithm_name(Board::Algorithm algorithm) {
+	switch (algorithm) {
+	case Board::Algorithm::sparse:
+		return "sparse";
+	case Board::Algorithm::tiled:
+		return "tiled";
+	case Board::Algorithm::morton:
+		return "morton";
+	case Board::Algorithm::hashlife:
+		return "hashlife";
+	case Board::Algorithm::unbounded:
+		return "unbounded";
+	default:
+		return "dense";
 	}
-	::wmove(scr, m_height, 0);
-	for (int col = 0; col < m_width; ++col)
-		::waddch(scr, '-');
-	::waddch(scr, '+');
 }
-template<>
-void Board::draw(sf::RenderTarget& target) const {
-	// sf::Texture x_texture;
-	// sf::Texture blank_texture;
-	// x_texture.loadFromFile("assets/x_texture.png");
-	// blank_texture.loadFromFile("assets/blank_texture.png");
-	sf::Font font;
-	font.loadFromFile("assets/arial.ttf");
-	sf::Text x_text;
-	x_text.setFont(font);
-	x_text.setString("x");
-	x_text.setFillColor(sf::Color::Black);
-	x_text.setCharacterSize(24);
-	// x_text.setStyle(sf::Text::Bold | sf::Text::Underlined);
-	double x_mul = 10;
-	double y_mul = 15;
-	for (int row = 0; row < m_height; ++row){
-		for (int col = 0; col < m_width; ++col) {
-			if (!m_board[row][col])
-				continue;
 
-			x_text.setPosition(x_mul * col, y_mul * row);
-			target.draw(x_text);
+std::optional<Board::Algorithm> algorithm_from_name(const std::string& name) {
+	for (auto algorithm : { Board::Algorithm::dense,
+			Board::Algorithm::sparse, Board::Algorithm::tiled,
+			Board::Algorithm::morton, Board::Algorithm::hashlife,
+			Board::Algorithm::unbounded })
+		if (name == algorithm_name(algorithm))
+			return algorithm;
+	return { };
+}
+
+std::optional<Board::Glyphs> glyphs_from_name(const std::string& name) {
+	if (name == "ascii")
+		return Board::Glyphs::ascii;
+	if (name == "half-block")
+		return Board::Glyphs::half_block;
+	if (name == "braille")
+		return Board::Glyphs::braille;
+	return { };
+}
+
+std::pair<int, int> glyph_size(Board::Glyphs glyphs) {
+	switch (glyphs) {
+	case Board::Glyphs::half_block:
+		return { 2, 1 };
+	case Board::Glyphs::braille:
+		return { 4, 2 };
+	default:
+		return { 1, 1 };
+	}
+}
+
+// Multibyte strings go through waddstr, which ncursesw decodes with the
+// locale, so the plain char interface serves every mode.
+void Board::draw_glyphs(WINDOW* scr, Glyphs glyphs, int y, int x_begin,
+		int x_end, int top, int left) const {
+	// none, upper, lower, both
+	static const char* const halves[4] = {
+		" ", "\xe2\x96\x80", "\xe2\x96\x84", "\xe2\x96\x88",
+	};
+	// bits of U+2800 + n: dots 1-3 and 7 down the left column, 4-6 and
+	// 8 down the right one
+	static constexpr int dots[4][2] = { { 0, 3 }, { 1, 4 }, { 2, 5 }, { 6, 7 } };
+
+	auto [glyph_rows, glyph_cols] = glyph_size(glyphs);
+	auto& board = current();
+	// cells past the board's edges are dead
+	auto alive = [&](int row, int col) {
+		return row < m_height && col < m_width && board.get(row, col);
+	};
+	auto row = top + y * glyph_rows;
+	::wmove(scr, y, x_begin);
+	for (int x = x_begin; x < x_end; ++x) {
+		auto col = left + x * glyph_cols;
+		switch (glyphs) {
+		case Glyphs::half_block:
+			::waddstr(scr, halves[alive(row, col) | alive(row + 1, col) << 1]);
+			break;
+		case Glyphs::braille:
+		{
+			unsigned bits = 0;
+			for (int dy = 0; dy < 4; ++dy)
+				for (int dx = 0; dx < 2; ++dx)
+					if (alive(row + dy, col + dx))
+						bits |= 1u << dots[dy][dx];
+			// a space is one byte instead of three, and ncurses can clear it
+			if (!bits) {
+				::waddch(scr, ' ');
+				break;
+			}
+			const char utf8[4] = { '\xe2', static_cast<char>(0xa0 | bits >> 6),
+				static_cast<char>(0x80 | (bits & 0x3f)), 0 };
+			::waddstr(scr, utf8);
+			break;
+		}
+		default:
+			::waddch(scr, alive(row, col) ? 'X' : ' ');
+			break;
 		}
 	}
+}
 
+// Only the visible cells are written, so a frame costs as much as the
+// window holds, whatever the size of the board.
+template<>
+void Board::draw(WINDOW* scr, int top, int left, Glyphs glyphs) const {
+	auto [glyph_rows, glyph_cols] = glyph_size(glyphs);
+	int rows, cols;
+	getmaxyx(scr, rows, cols);
+	// characters the board takes from (top, left) on
+	auto board_rows = std::max(m_height - top + glyph_rows - 1, 0) / glyph_rows;
+	auto board_cols = std::max(m_width - left + glyph_cols - 1, 0) / glyph_cols;
+	auto x_end = std::min(board_cols, cols);
+	// the right border is in sight
+	auto edge = board_cols < cols;
+	for (int y = 0; y < rows; ++y) {
+		auto written = 0;
+		::wmove(scr, y, 0);
+		if (y < board_rows) {
+			draw_glyphs(scr, glyphs, y, 0, x_end, top, left);
+			if (edge)
+				::waddch(scr, '|');
+			written = x_end + edge;
+		}
+		else if (y == board_rows) {
+			for (int x = 0; x < x_end; ++x)
+				::waddch(scr, '-');
+			if (edge)
+				::waddch(scr, '+');
+			written = x_end + edge;
+		}
+		// a full line has already moved the cursor to the next one
+		if (written < cols)
+			::wclrtoeol(scr);
+	}
+}
 
+template<>
+void Board::draw_damage(WINDOW* scr, int top, int left, Glyphs glyphs) const {
+	if (!m_damaged)
+		return;
+	auto [glyph_rows, glyph_cols] = glyph_size(glyphs);
+	int rows, cols;
+	getmaxyx(scr, rows, cols);
+	for (int y = 0; y < rows; ++y) {
+		auto row = top + y * glyph_rows;
+		if (row >= m_height)
+			break;
+		// spans of all rows of the character line together
+		auto begin = m_width;
+		auto end = 0;
+		for (int r = row; r < std::min(row + glyph_rows, m_height); ++r) {
+			auto [first, second] = m_damage[r];
+			if (first < second) {
+				begin = std::min(begin, first);
+				end = std::max(end, second);
+			}
+		}
+		begin = std::max(begin, left);
+		if (begin >= end)
+			continue;
+		auto x_begin = (begin - left) / glyph_cols;
+		auto x_end = std::min((end - left + glyph_cols - 1) / glyph_cols, cols);
+		if (x_begin < x_end)
+			draw_glyphs(scr, glyphs, y, x_begin, x_end, top, left);
+	}
 }
 
 void Board::dump_to_file(const std::string& name) {
 	std::ofstream file(name);
+	dump(file);
+}
+
+void Board::dump(std::ostream& file) {
 	file << "# Auto generated map file\n";
 	file << "x = " << m_width << ", y = " << m_height << ", ";
-	file << "rule = B";
-	for (auto&& iter : m_born)
-		file << iter;
-	file << "/S";
-	for (auto&& iter : m_survives)
-		file << iter;
+	file << "rule = ";
+	if (m_range_rule)
+		file << rule_name(*m_range_rule);
+	else if (m_isotropic)
+		file << 'B' << m_isotropic->born << "/S" << m_isotropic->survives;
+	else {
+		file << 'B';
+		for (int count = 0; count <= 8; ++count)
+			if ((m_rule.born >> count) & 1)
+				file << count;
+		file << "/S";
+		for (int count = 0; count <= 8; ++count)
+			if ((m_rule.survives >> count) & 1)
+				file << count;
+	}
 	file << std::endl;
 
 	int max_line_len = 80;
@@ -159,7 +863,7 @@ void Board::dump_to_file(const std::string& name) {
 		file << c;
 	};
 
-	auto out_string = [&](auto string) {
+	auto out_string = [&](std::string_view string) {
 		if (line_length + string.size() > (size_t)max_line_len) {
 			file << '\n';
 			line_length = 0;
@@ -176,8 +880,12 @@ void Board::dump_to_file(const std::string& name) {
 			++previous_char_counter;
 		else {
 			if (previous_char_counter > 1) {
-				out_string(std::to_string(previous_char_counter) +
-						previous_char);
+				// count and tag written in place, runs are frequent
+				char run[16];
+				auto run_end = std::to_chars(run, run + sizeof(run) - 1,
+						previous_char_counter).ptr;
+				*run_end++ = previous_char;
+				out_string(std::string_view(run, run_end - run));
 			}
 			else if (previous_char_counter == 1) {
 				out_char(previous_char);
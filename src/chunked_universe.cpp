@@ -0,0 +1,164 @@
+#include "chunked_universe.hpp"
+
+static const ChunkedUniverse::tile_t empty_tile = { };
+
+ChunkedUniverse::ChunkedUniverse(RuleMasks rule) :
+		m_rule(rule), m_generation(0) {
+}
+
+ChunkedUniverse::ChunkedUniverse(const ChunkedUniverse& other) :
+		m_rule(other.m_rule), m_tiles(other.m_tiles),
+		m_generation(other.m_generation) {
+}
+
+ChunkedUniverse& ChunkedUniverse::operator=(const ChunkedUniverse& other) {
+	if (this != &other)
+		*this = ChunkedUniverse(other);
+	return *this;
+}
+
+ChunkedUniverse::key_t ChunkedUniverse::key(std::int64_t tile_row,
+		std::int64_t tile_col) {
+	return (static_cast<key_t>(static_cast<std::uint32_t>(tile_row)) << 32) |
+		static_cast<std::uint32_t>(tile_col);
+}
+
+// rounds towards minus infinity
+std::int64_t ChunkedUniverse::tile_of(std::int64_t coordinate) {
+	return coordinate >= 0 ?
+		coordinate / tile_size : -((-coordinate - 1) / tile_size) - 1;
+}
+
+const ChunkedUniverse::tile_t* ChunkedUniverse::find(std::int64_t tile_row,
+		std::int64_t tile_col) const {
+	auto found = m_tiles.find(key(tile_row, tile_col));
+	return found == m_tiles.end() ? nullptr : &found->second;
+}
+
+void ChunkedUniverse::set(std::int64_t row, std::int64_t col, bool alive) {
+	auto tile_row = tile_of(row);
+	auto tile_col = tile_of(col);
+	auto bit = BitGrid::word_t(1) << (col - tile_col * tile_size);
+	auto& word = m_tiles[key(tile_row, tile_col)][row - tile_row * tile_size];
+	if (alive)
+		word |= bit;
+	else
+		word &= ~bit;
+}
+
+bool ChunkedUniverse::get(std::int64_t row, std::int64_t col) const {
+	auto tile_row = tile_of(row);
+	auto tile_col = tile_of(col);
+	auto tile = find(tile_row, tile_col);
+	if (!tile)
+		return false;
+	return ((*tile)[row - tile_row * tile_size] >>
+			(col - tile_col * tile_size)) & 1;
+}
+
+std::uint64_t ChunkedUniverse::population() const {
+	std::uint64_t result = 0;
+	for (auto&& iter : m_tiles)
+		for (auto&& word : iter.second)
+			result += __builtin_popcountll(word);
+	return result;
+}
+
+void ChunkedUniverse::step() {
+	while (!m_next_tiles.empty())
+		m_spare_tiles.push_back(m_next_tiles.extract(m_next_tiles.begin()));
+
+	auto step_tile = [&](std::int64_t tile_row, std::int64_t tile_col) {
+		auto target = key(tile_row, tile_col);
+		if (m_next_tiles.count(target))
+			return;
+
+		const BitGrid::word_t* neighbours[9];
+		bool any = false;
+		for (int y = 0; y < 3; ++y) {
+			for (int x = 0; x < 3; ++x) {
+				auto tile = find(tile_row + y - 1, tile_col + x - 1);
+				any |= tile != nullptr;
+				neighbours[y * 3 + x] = (tile ? *tile : empty_tile).data();
+			}
+		}
+		if (!any)
+			return;
+
+		tile_t result;
+		life_step_tile(neighbours, result.data(), m_rule);
+		for (auto&& word : result) {
+			if (!word)
+				continue;
+			if (m_spare_tiles.empty()) {
+				m_next_tiles.emplace(target, result);
+				return;
+			}
+			auto node = std::move(m_spare_tiles.back());
+			m_spare_tiles.pop_back();
+			node.key() = target;
+			node.mapped() = result;
+			m_next_tiles.insert(std::move(node));
+			return;
+		}
+	};
+
+	// new cells can only appear next to a live tile's border
+	for (auto&& iter : m_tiles) {
+		auto tile_row = static_cast<std::int32_t>(iter.first >> 32);
+		auto tile_col = static_cast<std::int32_t>(iter.first);
+		auto& tile = iter.second;
+
+		BitGrid::word_t any = 0;
+		BitGrid::word_t west = 0;
+		BitGrid::word_t east = 0;
+		for (auto&& word : tile) {
+			any |= word;
+			west |= word & 1;
+			east |= word >> (tile_size - 1);
+		}
+		if (!any)
+			continue;
+
+		bool north = tile.front();
+		bool south = tile.back();
+		for (int y = -1; y <= 1; ++y) {
+			for (int x = -1; x <= 1; ++x) {
+				if ((y < 0 && !north) || (y > 0 && !south) ||
+						(x < 0 && !west) || (x > 0 && !east))
+					continue;
+				step_tile(tile_row + y, tile_col + x);
+			}
+		}
+	}
+
+	std::swap(m_tiles, m_next_tiles);
+	++m_generation;
+}
+
+void ChunkedUniverse::render(BitGrid& grid,
+		std::int64_t top, std::int64_t left) const {
+	grid.clear();
+	for (auto&& iter : m_tiles) {
+		auto tile_top = static_cast<std::int32_t>(iter.first >> 32) *
+			std::int64_t(tile_size) - top;
+		auto tile_left = static_cast<std::int32_t>(iter.first) *
+			std::int64_t(tile_size) - left;
+		if (tile_top + tile_size <= 0 || tile_top >= grid.height() ||
+				tile_left + tile_size <= 0 || tile_left >= grid.width())
+			continue;
+
+		for (int row = 0; row < tile_size; ++row) {
+			auto word = iter.second[row];
+			auto grid_row = tile_top + row;
+			if (grid_row < 0 || grid_row >= grid.height())
+				continue;
+			while (word) {
+				auto grid_col = tile_left + __builtin_ctzll(word);
+				if (grid_col >= 0 && grid_col < grid.width())
+					grid.set(grid_row, grid_col, true);
+				word &= word - 1;
+			}
+		}
+	}
+}
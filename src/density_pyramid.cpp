@@ -0,0 +1,182 @@
+#include <algorithm>
+
+#include "density_pyramid.hpp"
+
+// rows and cols of the blocks update() checks for changes
+static constexpr int tile = BitGrid::word_bits;
+
+// any level of update()'s uint8, uint16 or uint32 counts
+template <class Level, class Function>
+static void with_counts(Level& level, Function&& function) {
+	if (!level.narrow.empty())
+		function(level.narrow);
+	else if (!level.medium.empty())
+		function(level.medium);
+	else
+		function(level.wide);
+}
+
+DensityPyramid::DensityPyramid(int height, int width) :
+		m_cells(height, width),
+		m_changed(static_cast<std::size_t>(m_cells.last_word()) + 1) {
+	m_sizes.emplace_back(width, height);
+	auto level_width = std::max(width, 1);
+	auto level_height = std::max(height, 1);
+	while (level_width > 1 || level_height > 1) {
+		level_width = (level_width + 1) / 2;
+		level_height = (level_height + 1) / 2;
+		m_sizes.emplace_back(level_width, level_height);
+		auto level = static_cast<int>(m_sizes.size()) - 1;
+		if (level < 2)
+			continue;
+		// a block holds up to 4^level cells
+		auto size = static_cast<std::size_t>(level_width) * level_height;
+		Level layer = { level_width, level_height, {}, {}, {} };
+		if (level <= 3)
+			layer.narrow.resize(size);
+		else if (level <= 7)
+			layer.medium.resize(size);
+		else
+			layer.wide.resize(size);
+		m_levels.push_back(std::move(layer));
+	}
+}
+
+DensityPyramid::count_t DensityPyramid::cell_count(int level, int row,
+		int col) const {
+	if (!level)
+		return m_cells.get(row, col);
+	// a 2 bit field in two rows, the row below the board is the dead halo
+	auto word = 2 * col / BitGrid::word_bits + 1;
+	auto shift = 2 * col % BitGrid::word_bits;
+	return __builtin_popcountll((m_cells.row(2 * row)[word] >> shift) & 3) +
+		__builtin_popcountll((m_cells.row(2 * row + 1)[word] >> shift) & 3);
+}
+
+void DensityPyramid::update(const BitGrid& grid) {
+	auto rows = std::min(grid.height(), m_cells.height());
+	auto last_word = std::min(grid.last_word(), m_cells.last_word());
+	for (int top = 0; top < rows; top += tile) {
+		auto bottom = std::min(top + tile, rows);
+		std::fill(m_changed.begin(), m_changed.end(), false);
+		bool changed = false;
+		for (int row = top; row < bottom; ++row) {
+			auto in = grid.row(row);
+			auto out = m_cells.row(row);
+			for (int word = 1; word <= last_word; ++word) {
+				auto value = in[word];
+				if (word == m_cells.last_word())
+					value &= m_cells.tail_mask();
+				if (out[word] != value) {
+					out[word] = value;
+					m_changed[word] = true;
+					changed = true;
+				}
+			}
+		}
+		if (!changed)
+			continue;
+
+		// blocks above runs of changed tiles on every level, row by row
+		for (int first = 1; first <= last_word; ) {
+			if (!m_changed[first]) {
+				++first;
+				continue;
+			}
+			auto last = first;
+			while (last < last_word && m_changed[last + 1])
+				++last;
+			auto left = (first - 1) * tile;
+			auto right = last * tile;
+			for (int level = 2; level < levels(); ++level) {
+				auto row_begin = top >> level;
+				auto row_end = std::min(((top + tile - 1) >> level) + 1,
+						height(level));
+				auto col_begin = left >> level;
+				auto col_end = std::min(((right - 1) >> level) + 1,
+						width(level));
+				if (level == 2)
+					count_cells(row_begin, row_end, col_begin, col_end);
+				else
+					count_level(level, row_begin, row_end, col_begin, col_end);
+			}
+			first = last + 1;
+		}
+	}
+}
+
+// A level 2 cell is a nibble in four rows. The nibbles of a word are
+// counted at once, and summed over the rows in bytes: even nibbles in one
+// word, odd ones in another.
+void DensityPyramid::count_cells(int row_begin, int row_end,
+		int col_begin, int col_end) {
+	constexpr auto pairs = BitGrid::word_t(0x5555555555555555);
+	constexpr auto nibbles = BitGrid::word_t(0x3333333333333333);
+	constexpr auto bytes = BitGrid::word_t(0x0f0f0f0f0f0f0f0f);
+	constexpr int fields = tile / 4;
+	auto& layer = m_levels[0];
+	for (int row = row_begin; row < row_end; ++row) {
+		// the halo row below the board is dead, there is none further
+		auto first = 4 * row;
+		auto last = std::min(first + 4, m_cells.height());
+		auto out = layer.narrow.data() + static_cast<std::size_t>(row) * layer.width;
+		for (int col = col_begin; col < col_end; ) {
+			auto word = col / fields + 1;
+			BitGrid::word_t even = 0;
+			BitGrid::word_t odd = 0;
+			for (int r = first; r < last; ++r) {
+				auto cells = m_cells.row(r)[word];
+				// 0 - 2 in every 2 bit field, then 0 - 4 in every nibble
+				auto counts = (cells & pairs) + ((cells >> 1) & pairs);
+				counts = (counts & nibbles) + ((counts >> 2) & nibbles);
+				even += counts & bytes;
+				odd += (counts >> 4) & bytes;
+			}
+			auto end = std::min(col_end, word * fields);
+			if (col % fields == 0 && end - col == fields) {
+				for (int byte = 0; byte < fields / 2; ++byte) {
+					out[col + 2 * byte] = (even >> (8 * byte)) & 0xff;
+					out[col + 2 * byte + 1] = (odd >> (8 * byte)) & 0xff;
+				}
+				col = end;
+				continue;
+			}
+			for (; col < end; ++col) {
+				auto shift = (col % fields) / 2 * 8;
+				out[col] = ((col & 1 ? odd : even) >> shift) & 0xff;
+			}
+		}
+	}
+}
+
+template <class In, class Out>
+static void sum_children(const std::vector<In>& below, int below_width,
+		int below_height, std::vector<Out>& counts, int width,
+		int row_begin, int row_end, int col_begin, int col_end) {
+	for (int row = row_begin; row < row_end; ++row) {
+		auto upper = below.data() + static_cast<std::size_t>(2 * row) * below_width;
+		// an odd level has no row below its last one
+		auto lower = 2 * row + 1 < below_height ? upper + below_width : nullptr;
+		auto out = counts.data() + static_cast<std::size_t>(row) * width;
+		for (int col = col_begin; col < col_end; ++col) {
+			auto left = 2 * col;
+			auto has_right = left + 1 < below_width;
+			unsigned sum = upper[left] + (has_right ? upper[left + 1] : 0);
+			if (lower)
+				sum += lower[left] + (has_right ? lower[left + 1] : 0);
+			out[col] = static_cast<Out>(sum);
+		}
+	}
+}
+
+void DensityPyramid::count_level(int level, int row_begin, int row_end,
+		int col_begin, int col_end) {
+	const auto& below = m_levels[level - 3];
+	auto& layer = m_levels[level - 2];
+	with_counts(below, [&](const auto& in) {
+		with_counts(layer, [&](auto& out) {
+			sum_children(in, below.width, below.height, out, layer.width,
+					row_begin, row_end, col_begin, col_end);
+		});
+	});
+}
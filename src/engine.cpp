@@ -1,26 +1,35 @@
 #include "engine.hpp"
 
 #include <curses.h>
+#include <algorithm>
 #include <chrono>
+#include <clocale>
+#include <cstdio>
 #include <thread>
+#include <tuple>
+#include <utility>
 
 #include <SFML/Graphics.hpp>
 
 #include <iostream>
 
+#include "sfml_renderer.hpp"
+
 
 using namespace std::chrono_literals;
 
 template<class Window>
 Engine<Window>::Engine(Window scr, const Board& board) :
-		m_board(board), m_scr(scr), m_iteration_duration(1000ms) {
+		m_board(board), m_scr(scr), m_iteration_duration(1000ms),
+		m_glyphs(Board::Glyphs::ascii) {
 	setupDisplay();
 	m_max_iterations = -1;
 }
 
 template<class Window>
 Engine<Window>::Engine(Window scr, Board&& board) :
-		m_board(board), m_scr(scr), m_iteration_duration(1000ms) {
+		m_board(std::move(board)), m_scr(scr), m_iteration_duration(1000ms),
+		m_glyphs(Board::Glyphs::ascii) {
 	setupDisplay();
 	m_max_iterations = -1;
 }
@@ -38,6 +47,11 @@ void Engine<Window>::setMaxIterations(int max) {
 	m_max_iterations = max;
 }
 
+template<class Window>
+void Engine<Window>::setGlyphs(Board::Glyphs glyphs) {
+	m_glyphs = glyphs;
+}
+
 template<class Window>
 void Engine<Window>::setupDisplay() {
 
@@ -49,6 +63,8 @@ void Engine<WINDOW*>::setupDisplay() {
 	if (was_done)
 		return;
 
+	// multibyte glyphs are decoded with it
+	std::setlocale(LC_ALL, "");
 	initscr();
 	cbreak();
 	noecho();
@@ -83,13 +99,15 @@ void Engine<WINDOW*>::display_help() {
 
 	print("HELP\n");
 
-	print("- use arrows to move");
+	print("- use arrows to move, the view scrolls with the cursor");
+	print("- to jump to a cell press 'g'");
 	print("- to diplay this help message press F1");
 	print("- to quit press 'q'");
 	print("- to pause game press spacebar");
 	print("- to kill cell press 'k'");
 	print("- to resurrect cell press 'x'");
 	print("- to save game press 's'");
+	print("- to go back one generation press 'r'");
 
 	::wrefresh(m_scr);
 
@@ -98,6 +116,30 @@ void Engine<WINDOW*>::display_help() {
 
 }
 
+template<>
+bool Engine<sf::RenderWindow&>::display_jump(int&, int&) {
+	return false;
+}
+
+// on the last line of the window, the board is redrawn afterwards
+template<>
+bool Engine<WINDOW*>::display_jump(int& row, int& col) {
+	::wmove(m_scr, getmaxy(m_scr) - 1, 0);
+	::wclrtoeol(m_scr);
+	::waddstr(m_scr, "Go to row col: ");
+	echo();
+	timeout(-1);
+	::wrefresh(m_scr);
+
+	char line[64];
+	auto read = ::wgetnstr(m_scr, line, sizeof(line) - 1) != ERR &&
+		std::sscanf(line, "%d%*[ ,]%d", &row, &col) == 2;
+
+	noecho();
+	timeout(0);
+	return read;
+}
+
 template<>
 void Engine<sf::RenderWindow&>::display_save() {
 
@@ -157,22 +199,98 @@ void Engine<sf::RenderWindow&>::loop() {
 	int iterations = 0;
 	bool pause = false;
 
+	// the texture only changes with the board and the view
+	SfmlRenderer renderer(m_board.height(), m_board.width());
+	renderer.update(m_board.generation(0));
+	renderer.fit(window.getSize());
+
+	// pixels an arrow key moves the board by, and the zoom of one step
+	constexpr float pan_step = 64;
+	constexpr float zoom_step = 1.25f;
+	bool dragging = false;
+	sf::Vector2f drag_from;
+
 	while (window.isOpen()) {
 		window.clear(sf::Color::White);
-		m_board.draw<sf::RenderTarget&>(window);
+		renderer.draw(window);
 		window.display();
 
 		sf::Event event;
 		while (window.pollEvent(event)) {
-
-			if(event.type == sf::Event::Closed)
+			auto size = window.getSize();
+			sf::Vector2f centre(size.x / 2.f, size.y / 2.f);
+			switch (event.type) {
+			case sf::Event::Closed:
 				window.close();
-
+				break;
+			case sf::Event::Resized:
+				// one unit per pixel instead of stretching the old view
+				window.setView(sf::View(sf::FloatRect(0, 0,
+								event.size.width, event.size.height)));
+				break;
+			case sf::Event::MouseWheelScrolled:
+				renderer.zoom(event.mouseWheelScroll.delta > 0 ?
+						zoom_step : 1 / zoom_step,
+						sf::Vector2f(event.mouseWheelScroll.x,
+							event.mouseWheelScroll.y));
+				break;
+			case sf::Event::MouseButtonPressed:
+				if (event.mouseButton.button == sf::Mouse::Left) {
+					dragging = true;
+					drag_from = sf::Vector2f(event.mouseButton.x,
+							event.mouseButton.y);
+				}
+				break;
+			case sf::Event::MouseButtonReleased:
+				if (event.mouseButton.button == sf::Mouse::Left)
+					dragging = false;
+				break;
+			case sf::Event::MouseMoved:
+				if (dragging) {
+					sf::Vector2f to(event.mouseMove.x, event.mouseMove.y);
+					renderer.pan(sf::Vector2f(to.x - drag_from.x,
+								to.y - drag_from.y));
+					drag_from = to;
+				}
+				break;
+			case sf::Event::KeyPressed:
+				switch (event.key.code) {
+				case sf::Keyboard::Left:
+					renderer.pan(sf::Vector2f(pan_step, 0));
+					break;
+				case sf::Keyboard::Right:
+					renderer.pan(sf::Vector2f(-pan_step, 0));
+					break;
+				case sf::Keyboard::Up:
+					renderer.pan(sf::Vector2f(0, pan_step));
+					break;
+				case sf::Keyboard::Down:
+					renderer.pan(sf::Vector2f(0, -pan_step));
+					break;
+				case sf::Keyboard::Add:
+				case sf::Keyboard::Equal:
+					renderer.zoom(zoom_step, centre);
+					break;
+				case sf::Keyboard::Subtract:
+				case sf::Keyboard::Hyphen:
+					renderer.zoom(1 / zoom_step, centre);
+					break;
+				case sf::Keyboard::Home:
+					renderer.fit(size);
+					break;
+				default:
+					break;
+				}
+				break;
+			default:
+				break;
+			}
 		}
 		if (!pause) {
 			auto elapsed = now() - timer;
 			if (elapsed > refresh_rate) {
 				m_board.iterate();
+				renderer.update(m_board.generation(0));
 				iterations++;
 				timer += refresh_rate;
 			}
@@ -192,18 +310,59 @@ void Engine<WINDOW*>::loop() {
 	auto refresh_rate = m_iteration_duration;
 
 
+	// cursor in board cells, and the cell in the window's top left corner
 	int posx = 0;
 	int posy = 0;
+	int top = 0;
+	int left = 0;
 
 	int iterations = 0;
 	if (!m_scr)
 		m_scr = stdscr;
 
+	// after that only cells the board reports as changed are drawn, and
+	// the terminal is only refreshed when something was
+	m_board.set_damage_tracking(true);
+	bool redraw = true;
+	int shown_x = -1;
+	int shown_y = -1;
+
+	// cells per character, the view moves by whole characters
+	int glyph_rows, glyph_cols;
+	std::tie(glyph_rows, glyph_cols) = glyph_size(m_glyphs);
+
+	// scrolls the view as little as it takes to show the cursor
+	auto follow_cursor = [&]() {
+		int rows, cols;
+		getmaxyx(m_scr, rows, cols);
+		posx = std::clamp(posx, 0, std::max(m_board.width() - 1, 0));
+		posy = std::clamp(posy, 0, std::max(m_board.height() - 1, 0));
+		auto x = posx / glyph_cols;
+		auto y = posy / glyph_rows;
+		auto new_left = std::clamp(left / glyph_cols, x - cols + 1, x) * glyph_cols;
+		auto new_top = std::clamp(top / glyph_rows, y - rows + 1, y) * glyph_rows;
+		if (new_left != left || new_top != top) {
+			left = new_left;
+			top = new_top;
+			redraw = true;
+		}
+	};
+
 	while (!exit_loop && 
 			(m_max_iterations == -1 || iterations < m_max_iterations)) {
-		m_board.draw(m_scr);
-		::wmove(m_scr, posy, posx);
-		::wrefresh(m_scr);
+		bool changed = redraw || m_board.damaged();
+		if (redraw)
+			m_board.draw(m_scr, top, left, m_glyphs);
+		else
+			m_board.draw_damage(m_scr, top, left, m_glyphs);
+		m_board.clear_damage();
+		redraw = false;
+		::wmove(m_scr, (posy - top) / glyph_rows, (posx - left) / glyph_cols);
+		if (changed || posx != shown_x || posy != shown_y) {
+			::wrefresh(m_scr);
+			shown_x = posx;
+			shown_y = posy;
+		}
 
 		int ch = ::getch();
 		switch (ch) {
@@ -217,39 +376,62 @@ void Engine<WINDOW*>::loop() {
 				break;
 			case 'x':
 			case 'k':
-			{
-				int y, x;
-				getyx(m_scr, y, x);
 				if (ch == 'x')
-					m_board.add_at(y, x);
+					m_board.add_at(posy, posx);
 				else
-					m_board.kill_at(y, x);
+					m_board.kill_at(posy, posx);
 				break;
-			}
 			case KEY_LEFT:
-				if (posx)
-					posx--;
+				posx--;
 				break;
 			case KEY_RIGHT:
 				posx++;
 				break;
 			case KEY_UP:
-				if (posy)
-					posy--;
+				posy--;
 				break;
 			case KEY_DOWN:
 				posy++;
 				break;
+			case 'g':
+			{
+				int row, col;
+				if (display_jump(row, col)) {
+					// the cell in the middle of the window
+					int rows, cols;
+					getmaxyx(m_scr, rows, cols);
+					posy = row;
+					posx = col;
+					top = std::max(row / glyph_rows - rows / 2, 0) * glyph_rows;
+					left = std::max(col / glyph_cols - cols / 2, 0) * glyph_cols;
+				}
+				timer = now() - refresh_rate;
+				redraw = true;
+				break;
+			}
+			case KEY_RESIZE:
+				redraw = true;
+				break;
 			case KEY_F(1):
 				display_help();
 				timer = now() - refresh_rate;
+				redraw = true;
 				break;
 			case 's':
 				display_save();
 				timer = now() - refresh_rate;
+				redraw = true;
+				break;
+			case 'r':
+				if (m_board.rewind()) {
+					pause = true;
+					if (iterations)
+						iterations--;
+				}
 				break;
 
 		}
+		follow_cursor();
 		std::this_thread::sleep_for(10ms);
 		
 
@@ -0,0 +1,151 @@
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+#include <sys/mman.h>
+
+#include "grid_storage.hpp"
+
+namespace {
+
+constexpr std::size_t page_size = 4096;
+// x86-64 and most arm64 kernels
+constexpr std::size_t huge_page_size = std::size_t(2) << 20;
+// smaller buffers come from malloc
+constexpr std::size_t map_threshold = std::size_t(1) << 20;
+
+std::size_t round_up(std::size_t value, std::size_t multiple) {
+	return (value + multiple - 1) / multiple * multiple;
+}
+
+}
+
+GridStorage& GridStorage::instance() {
+	// grids in static storage may be destroyed after it otherwise
+	static auto storage = new GridStorage();
+	return *storage;
+}
+
+void GridStorage::set_huge_pages(HugePages huge_pages) {
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_huge_pages = huge_pages;
+}
+
+void GridStorage::set_cache_limit(std::size_t bytes) {
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_cache_limit = bytes;
+}
+
+void GridStorage::trim() {
+	std::lock_guard<std::mutex> lock(m_mutex);
+	for (auto&& iter : m_free)
+		for (auto buffer : iter.second)
+			unmap(buffer, iter.first);
+	m_free.clear();
+	m_cached = 0;
+}
+
+// depends on the size only, so a block can be reused and unmapped
+// whatever the huge page setting was when it was allocated
+std::size_t GridStorage::block_size(std::size_t bytes) {
+	if (bytes >= huge_page_size)
+		return round_up(bytes, huge_page_size);
+	if (bytes >= map_threshold)
+		return round_up(bytes, page_size);
+	return round_up(bytes, alignment);
+}
+
+void* GridStorage::allocate(std::size_t bytes) {
+	auto size = block_size(bytes);
+	std::lock_guard<std::mutex> lock(m_mutex);
+	auto free = m_free.find(size);
+	if (free != m_free.end() && !free->second.empty()) {
+		auto buffer = free->second.back();
+		free->second.pop_back();
+		m_cached -= size;
+		return buffer;
+	}
+
+	void* buffer = size < map_threshold ?
+		std::aligned_alloc(alignment, size) : map(size);
+	if (!buffer)
+		throw std::bad_alloc();
+	return buffer;
+}
+
+void GridStorage::release(void* buffer, std::size_t bytes) {
+	auto size = block_size(bytes);
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		if (m_cached + size <= m_cache_limit) {
+			m_free[size].push_back(buffer);
+			m_cached += size;
+			return;
+		}
+	}
+	unmap(buffer, size);
+}
+
+// size as returned by block_size()
+void GridStorage::unmap(void* buffer, std::size_t size) {
+	if (size < map_threshold)
+		std::free(buffer);
+	else
+		munmap(buffer, size);
+}
+
+// huge pages need the mapping aligned to their size, so a larger one is
+// mapped and trimmed
+void* GridStorage::map(std::size_t size) {
+	auto protection = PROT_READ | PROT_WRITE;
+	auto flags = MAP_PRIVATE | MAP_ANONYMOUS;
+	if (size % huge_page_size) {
+		auto buffer = mmap(nullptr, size, protection, flags, -1, 0);
+		return buffer == MAP_FAILED ? nullptr : buffer;
+	}
+
+#ifdef MAP_HUGETLB
+	if (m_huge_pages == HugePages::reserved) {
+		auto buffer = mmap(nullptr, size, protection, flags | MAP_HUGETLB,
+				-1, 0);
+		if (buffer != MAP_FAILED)
+			return buffer;
+	}
+#endif // MAP_HUGETLB
+
+	auto mapped = mmap(nullptr, size + huge_page_size, protection, flags,
+			-1, 0);
+	if (mapped == MAP_FAILED)
+		return nullptr;
+	auto begin = reinterpret_cast<std::uintptr_t>(mapped);
+	auto aligned = round_up(begin, huge_page_size);
+	if (aligned != begin)
+		munmap(mapped, aligned - begin);
+	if (auto tail = begin + huge_page_size - aligned)
+		munmap(reinterpret_cast<void*>(aligned + size), tail);
+
+	auto buffer = reinterpret_cast<void*>(aligned);
+#if defined(MADV_HUGEPAGE) && defined(MADV_NOHUGEPAGE)
+	madvise(buffer, size, m_huge_pages == HugePages::off ?
+			MADV_NOHUGEPAGE : MADV_HUGEPAGE);
+#endif
+	return buffer;
+}
+
+const char* huge_pages_name(HugePages huge_pages) {
+	switch (huge_pages) {
+	case HugePages::off:
+		return "off";
+	case HugePages::reserved:
+		return "reserved";
+	default:
+		return "transparent";
+	}
+}
+
+std::optional<HugePages> huge_pages_from_name(const std::string& name) {
+	for (auto huge_pages : { HugePages::off, HugePages::transparent,
+			HugePages::reserved })
+		if (name == huge_pages_name(huge_pages))
+			return huge_pages;
+	return { };
+}
@@ -0,0 +1,270 @@
+#include <algorithm>
+
+#include "hashlife.hpp"
+
+// cached nodes above this are dropped before the next step
+static constexpr std::size_t max_nodes = 1 << 22;
+
+std::size_t HashLife::NodeKeyHash::operator()(const node_key_t& key) const {
+	std::uint64_t result = 0;
+	for (auto&& iter : key) {
+		result ^= reinterpret_cast<std::uintptr_t>(iter);
+		result *= 0x9e3779b97f4a7c15ull;
+		result ^= result >> 29;
+	}
+	return result;
+}
+
+HashLife::HashLife(RuleMasks rule) : m_rule(rule), m_generation(0) {
+	m_nodes.push_back({ nullptr, nullptr, nullptr, nullptr, 0, 0, nullptr, -1 });
+	m_nodes.push_back({ nullptr, nullptr, nullptr, nullptr, 0, 1, nullptr, -1 });
+	m_dead = &m_nodes[0];
+	m_alive = &m_nodes[1];
+	m_root = empty(3);
+}
+
+HashLife::HashLife(const HashLife& other) : HashLife(other.m_rule) {
+	std::unordered_map<const Node*, const Node*> copied;
+	copied[other.m_dead] = m_dead;
+	copied[other.m_alive] = m_alive;
+	m_root = copy_tree(other.m_root, copied);
+	m_generation = other.m_generation;
+}
+
+HashLife& HashLife::operator=(const HashLife& other) {
+	HashLife copy(other);
+	return *this = std::move(copy);
+}
+
+void HashLife::set_rule(RuleMasks rule) {
+	m_rule = rule;
+	for (auto&& iter : m_nodes) {
+		iter.result = nullptr;
+		iter.result_step = -1;
+	}
+}
+
+const HashLife::Node* HashLife::join(const Node* nw, const Node* ne,
+		const Node* sw, const Node* se) {
+	node_key_t key = { nw, ne, sw, se };
+	auto found = m_table.find(key);
+	if (found != m_table.end())
+		return found->second;
+
+	m_nodes.push_back({ nw, ne, sw, se, nw->level + 1,
+			nw->population + ne->population + sw->population + se->population,
+			nullptr, -1 });
+	auto result = &m_nodes.back();
+	m_table.emplace(key, result);
+	return result;
+}
+
+const HashLife::Node* HashLife::empty(int level) {
+	if (m_empty.empty())
+		m_empty.push_back(m_dead);
+	while (static_cast<int>(m_empty.size()) <= level) {
+		auto previous = m_empty.back();
+		m_empty.push_back(join(previous, previous, previous, previous));
+	}
+	return m_empty[level];
+}
+
+const HashLife::Node* HashLife::centre(const Node* node) {
+	return join(node->nw->se, node->ne->sw, node->sw->ne, node->se->nw);
+}
+
+const HashLife::Node* HashLife::expand(const Node* node) {
+	auto border = empty(node->level - 1);
+	return join(join(border, border, border, node->nw),
+			join(border, border, node->ne, border),
+			join(border, node->sw, border, border),
+			join(node->se, border, border, border));
+}
+
+const HashLife::Node* HashLife::set(const Node* node,
+		std::int64_t row, std::int64_t col, bool alive) {
+	if (!node->level)
+		return alive ? m_alive : m_dead;
+
+	auto half = std::int64_t(1) << (node->level - 1);
+	auto nw = node->nw;
+	auto ne = node->ne;
+	auto sw = node->sw;
+	auto se = node->se;
+	if (row < half) {
+		if (col < half)
+			nw = set(nw, row, col, alive);
+		else
+			ne = set(ne, row, col - half, alive);
+	}
+	else {
+		if (col < half)
+			sw = set(sw, row - half, col, alive);
+		else
+			se = set(se, row - half, col - half, alive);
+	}
+	return join(nw, ne, sw, se);
+}
+
+void HashLife::set(std::int64_t row, std::int64_t col, bool alive) {
+	while (row < -half_size() || row >= half_size() ||
+			col < -half_size() || col >= half_size())
+		m_root = expand(m_root);
+	m_root = set(m_root, row + half_size(), col + half_size(), alive);
+}
+
+bool HashLife::get(std::int64_t row, std::int64_t col) const {
+	if (row < -half_size() || row >= half_size() ||
+			col < -half_size() || col >= half_size())
+		return false;
+	row += half_size();
+	col += half_size();
+	auto node = m_root;
+	while (node->level) {
+		auto half = std::int64_t(1) << (node->level - 1);
+		if (row < half)
+			node = col < half ? node->nw : node->ne;
+		else
+			node = col < half ? node->sw : node->se;
+		row %= half;
+		col %= half;
+	}
+	return node->population;
+}
+
+std::uint64_t HashLife::population() const {
+	return m_root->population;
+}
+
+// 4x4 node, centre 2x2 after one generation
+const HashLife::Node* HashLife::base_step(const Node* node) {
+	unsigned cells = 0;
+	for (int row = 0; row < 4; ++row) {
+		for (int col = 0; col < 4; ++col) {
+			auto quarter = row < 2 ?
+				(col < 2 ? node->nw : node->ne) :
+				(col < 2 ? node->sw : node->se);
+			auto leaf = (row & 1) ?
+				((col & 1) ? quarter->se : quarter->sw) :
+				((col & 1) ? quarter->ne : quarter->nw);
+			if (leaf->population)
+				cells |= 1u << (row * 4 + col);
+		}
+	}
+
+	auto next = [&](int row, int col) {
+		int count = 0;
+		for (int r = row - 1; r <= row + 1; ++r)
+			for (int c = col - 1; c <= col + 1; ++c)
+				if (r != row || c != col)
+					count += (cells >> (r * 4 + c)) & 1;
+		auto mask = (cells >> (row * 4 + col)) & 1 ?
+			m_rule.survives : m_rule.born;
+		return (mask >> count) & 1 ? m_alive : m_dead;
+	};
+	return join(next(1, 1), next(1, 2), next(2, 1), next(2, 2));
+}
+
+// centre of node after 2^step_log generations, step_log <= level - 2
+const HashLife::Node* HashLife::successor(const Node* node, int step_log) {
+	if (!node->population)
+		return empty(node->level - 1);
+	if (node->result && node->result_step == step_log)
+		return node->result;
+
+	const Node* result;
+	if (node->level == 2) {
+		result = base_step(node);
+	}
+	else {
+		// nine overlapping subsquares, half the size of node
+		auto nw = node->nw;
+		auto ne = node->ne;
+		auto sw = node->sw;
+		auto se = node->se;
+		bool full_step = step_log == node->level - 2;
+		auto inner_step = full_step ? step_log - 1 : step_log;
+
+		auto c00 = successor(nw, inner_step);
+		auto c01 = successor(join(nw->ne, ne->nw, nw->se, ne->sw), inner_step);
+		auto c02 = successor(ne, inner_step);
+		auto c10 = successor(join(nw->sw, nw->se, sw->nw, sw->ne), inner_step);
+		auto c11 = successor(join(nw->se, ne->sw, sw->ne, se->nw), inner_step);
+		auto c12 = successor(join(ne->sw, ne->se, se->nw, se->ne), inner_step);
+		auto c20 = successor(sw, inner_step);
+		auto c21 = successor(join(sw->ne, se->nw, sw->se, se->sw), inner_step);
+		auto c22 = successor(se, inner_step);
+
+		if (full_step) {
+			// second half of the generations
+			result = join(
+				successor(join(c00, c01, c10, c11), inner_step),
+				successor(join(c01, c02, c11, c12), inner_step),
+				successor(join(c10, c11, c20, c21), inner_step),
+				successor(join(c11, c12, c21, c22), inner_step));
+		}
+		else {
+			result = join(
+				centre(join(c00, c01, c10, c11)),
+				centre(join(c01, c02, c11, c12)),
+				centre(join(c10, c11, c20, c21)),
+				centre(join(c11, c12, c21, c22)));
+		}
+	}
+
+	node->result = result;
+	node->result_step = step_log;
+	return result;
+}
+
+void HashLife::step(int step_log) {
+	step_log = std::clamp(step_log, 0, max_step_log);
+	if (m_table.size() > max_nodes)
+		*this = HashLife(*this);
+
+	// the pattern has to stay inside the returned centre, so it has to
+	// start in the middle quarter and move at most an eighth of the root
+	while (m_root->level < step_log + 3 ||
+			centre(m_root)->population != m_root->population ||
+			centre(centre(m_root))->population != m_root->population)
+		m_root = expand(m_root);
+	m_root = successor(m_root, step_log);
+	m_generation += std::uint64_t(1) << step_log;
+}
+
+const HashLife::Node* HashLife::copy_tree(const Node* node,
+		std::unordered_map<const Node*, const Node*>& copied) {
+	auto found = copied.find(node);
+	if (found != copied.end())
+		return found->second;
+	auto result = join(copy_tree(node->nw, copied), copy_tree(node->ne, copied),
+			copy_tree(node->sw, copied), copy_tree(node->se, copied));
+	copied.emplace(node, result);
+	return result;
+}
+
+void HashLife::render(BitGrid& grid,
+		std::int64_t top, std::int64_t left) const {
+	grid.clear();
+	render(m_root, -half_size(), -half_size(), grid, top, left);
+}
+
+void HashLife::render(const Node* node, std::int64_t row, std::int64_t col,
+		BitGrid& grid, std::int64_t top, std::int64_t left) const {
+	auto size = std::int64_t(1) << node->level;
+	if (!node->population ||
+			row + size <= top || row >= top + grid.height() ||
+			col + size <= left || col >= left + grid.width())
+		return;
+
+	if (!node->level) {
+		grid.set(row - top, col - left, true);
+		return;
+	}
+
+	auto half = size / 2;
+	render(node->nw, row, col, grid, top, left);
+	render(node->ne, row, col + half, grid, top, left);
+	render(node->sw, row + half, col, grid, top, left);
+	render(node->se, row + half, col + half, grid, top, left);
+}
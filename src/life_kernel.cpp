@@ -0,0 +1,145 @@
+#include <algorithm>
+
+#include "life_kernel.hpp"
+#include "life_kernel_impl.hpp"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define LIFE_KERNEL_X86
+#endif
+
+life_kernel_t life_kernel_scalar(RuleMasks rule) {
+	return select_kernel<word_t>(rule);
+}
+
+life_tile_kernel_t life_tile_kernel_scalar(RuleMasks rule) {
+	return select_tile_kernel<word_t>(rule);
+}
+
+void life_step_tile(const word_t* const neighbours[9], word_t* out,
+		RuleMasks rule) {
+	life_tile_kernel_scalar(rule)(neighbours, out, rule);
+}
+
+void life_step_table(const BitGrid& src, BitGrid& dst,
+		int row_begin, int row_end, int word_begin, int word_end,
+		const unsigned char* table) {
+	auto last = src.last_word();
+	for (int row = row_begin; row < row_end; ++row) {
+		const word_t* rows[3] = {
+			src.row(row - 1), src.row(row), src.row(row + 1)
+		};
+		auto out = dst.row(row);
+		for (int word = word_begin; word < word_end; ++word) {
+			// the index slides east one column per cell: columns move
+			// from bits 2 / 1 / 0 of every row to 1 / 0 / out, the new
+			// east column comes in at bit 2
+			unsigned index = 0;
+			word_t east[3];
+			for (int i = 0; i < 3; ++i) {
+				auto shift = 3 * i;
+				index |= (rows[i][word - 1] >> 63) << (shift + 1) |
+					(rows[i][word] & 1) << (shift + 2);
+				east[i] = (rows[i][word] >> 1) | (rows[i][word + 1] << 63);
+			}
+			word_t result = 0;
+			for (int bit = 0; bit < BitGrid::word_bits; ++bit) {
+				index = (index >> 1 & 0b011011011) |
+					(east[0] >> bit & 1) << 2 |
+					(east[1] >> bit & 1) << 5 |
+					(east[2] >> bit & 1) << 8;
+				result |= word_t(table[index]) << bit;
+			}
+			out[word] = result;
+		}
+		if (word_begin <= last && last < word_end)
+			out[last] &= src.tail_mask();
+	}
+}
+
+bool kernel_supported(Kernel kernel) {
+	switch (kernel) {
+	case Kernel::scalar:
+	case Kernel::automatic:
+		return true;
+#ifdef LIFE_KERNEL_X86
+	case Kernel::sse2:
+		return __builtin_cpu_supports("sse2");
+	case Kernel::avx2:
+		return __builtin_cpu_supports("avx2");
+	case Kernel::avx512:
+		return __builtin_cpu_supports("avx512f");
+#endif // LIFE_KERNEL_X86
+	default:
+		return false;
+	}
+}
+
+Kernel best_kernel() {
+	for (auto kernel : { Kernel::avx512, Kernel::avx2, Kernel::sse2 })
+		if (kernel_supported(kernel))
+			return kernel;
+	return Kernel::scalar;
+}
+
+life_kernel_t life_kernel(Kernel kernel, RuleMasks rule) {
+	if (!kernel_supported(kernel))
+		return nullptr;
+
+	switch (kernel) {
+#ifdef LIFE_KERNEL_X86
+	case Kernel::sse2:
+		return life_kernel_sse2(rule);
+	case Kernel::avx2:
+		return life_kernel_avx2(rule);
+	case Kernel::avx512:
+		return life_kernel_avx512(rule);
+#endif // LIFE_KERNEL_X86
+	case Kernel::automatic:
+		return life_kernel(best_kernel(), rule);
+	default:
+		return life_kernel_scalar(rule);
+	}
+}
+
+life_tile_kernel_t life_tile_kernel(Kernel kernel, RuleMasks rule) {
+	if (!kernel_supported(kernel))
+		return nullptr;
+
+	switch (kernel) {
+#ifdef LIFE_KERNEL_X86
+	case Kernel::sse2:
+		return life_tile_kernel_sse2(rule);
+	case Kernel::avx2:
+		return life_tile_kernel_avx2(rule);
+	case Kernel::avx512:
+		return life_tile_kernel_avx512(rule);
+#endif // LIFE_KERNEL_X86
+	case Kernel::automatic:
+		return life_tile_kernel(best_kernel(), rule);
+	default:
+		return life_tile_kernel_scalar(rule);
+	}
+}
+
+const char* kernel_name(Kernel kernel) {
+	switch (kernel) {
+	case Kernel::scalar:
+		return "scalar";
+	case Kernel::sse2:
+		return "sse2";
+	case Kernel::avx2:
+		return "avx2";
+	case Kernel::avx512:
+		return "avx512";
+	default:
+		return "auto";
+	}
+}
+
+std::optional<Kernel> kernel_from_name(const std::string& name) {
+	for (auto kernel : { Kernel::scalar, Kernel::sse2, Kernel::avx2,
+			Kernel::avx512, Kernel::automatic })
+		if (name == kernel_name(kernel))
+			return kernel;
+	return { };
+}
@@ -0,0 +1,18 @@
+// compiled with -mavx512f, only called when the cpu supports it
+#if defined(__x86_64__) || defined(__i386__)
+
+#include "life_kernel_impl.hpp"
+
+namespace {
+using vec_t = word_t __attribute__((vector_size(8 * sizeof(word_t))));
+}
+
+life_kernel_t life_kernel_avx512(RuleMasks rule) {
+	return select_kernel<vec_t>(rule);
+}
+
+life_tile_kernel_t life_tile_kernel_avx512(RuleMasks rule) {
+	return select_tile_kernel<vec_t>(rule);
+}
+
+#endif // x86
@@ -44,6 +44,44 @@ std::istream& operator>>(std::istream& stream, coordinates_pair& pair) {
 	return stream;
 }
 
+static void print_thread_stats(const ThreadPool& pool) {
+	using std::chrono::duration_cast;
+	using std::chrono::microseconds;
+	auto run_time = duration_cast<microseconds>(pool.run_time()).count();
+	for (std::size_t i = 0; i < pool.stats().size(); ++i) {
+		auto&& stats = pool.stats()[i];
+		auto busy = duration_cast<microseconds>(stats.busy).count();
+		std::cerr << "thread " << i << ": " << stats.tasks << " tasks, " <<
+			stats.steals << " steals, busy " <<
+			(run_time ? 100 * busy / run_time : 0) << "%\n";
+	}
+}
+
+// as fast as possible without a display, the final board goes to output
+// or stdout and the throughput to stderr
+static void run_headless(Board& board, int iterations,
+		const std::optional<std::string>& output) {
+	auto start = std::chrono::steady_clock::now();
+	for (int i = 0; i < iterations; ++i)
+		board.iterate();
+	std::chrono::duration<double> elapsed =
+		std::chrono::steady_clock::now() - start;
+
+	if (output)
+		board.dump_to_file(*output);
+	else
+		board.dump(std::cout);
+
+	auto generations = board.generations_per_iteration() * iterations;
+	auto cells = static_cast<double>(generations) *
+		board.width() * board.height();
+	auto seconds = elapsed.count();
+	std::cerr << iterations << " iterations, " << generations <<
+		" generations in " << seconds << " s, " <<
+		(seconds > 0 ? generations / seconds : 0) << " generations/s, " <<
+		(seconds > 0 ? cells / seconds : 0) << " cells/s\n";
+}
+
 int main(int argc, char* argv[]) {
 	
 	po::options_description desc("Allowed options");
@@ -61,6 +99,32 @@ int main(int argc, char* argv[]) {
 		("input-file,i", po::value<std::string>(),
 			".rtl input file")
 		("graphic", "use graphical interface")
+		("glyphs", po::value<std::string>()->default_value("ascii"),
+			"cells per terminal character: ascii (1), half-block (2) or "
+			"braille (8), the last two need a UTF-8 terminal")
+		("headless", "run max-iterations iterations without a display, "
+			"then print the board and the throughput")
+		("output,o", po::value<std::string>(),
+			"file the headless run writes the board to (default stdout)")
+		("kernel", po::value<std::string>()->default_value("auto"),
+			"life kernel: scalar|sse2|avx2|avx512|auto")
+		("threads", po::value<int>(),
+			"number of threads computing generations (0 - all cores)")
+		("engine", po::value<std::string>()->default_value("dense"),
+			"simulation engine: dense|sparse|tiled|morton|hashlife|unbounded")
+		("tile-size", po::value<int>(),
+			"side of the tiled engine's tiles in cells (0 - fit the L2 cache)")
+		("tile-generations", po::value<int>(),
+			"tiled engine advances N generations per iteration")
+		("thread-stats", "print per thread load after the run")
+		("topology", po::value<std::string>()->default_value("plane"),
+			"board edges: plane|torus|klein|cross")
+		("hashlife-step", po::value<int>(),
+			"hashlife advances 2^N generations per iteration")
+		("history", po::value<int>(),
+			"number of past generations kept for rewinding")
+		("huge-pages", po::value<std::string>()->default_value("transparent"),
+			"board storage pages: off|transparent|reserved")
 		;
 
 	po::variables_map vm;
@@ -73,6 +137,15 @@ int main(int argc, char* argv[]) {
 		return EXIT_SUCCESS;
 	}
 
+	// before any board is allocated
+	auto huge_pages = huge_pages_from_name(vm["huge-pages"].as<std::string>());
+	if (!huge_pages) {
+		std::cerr << "Unknown huge pages mode " <<
+			vm["huge-pages"].as<std::string>() << '\n';
+		return EXIT_FAILURE;
+	}
+	GridStorage::instance().set_huge_pages(*huge_pages);
+
 	std::optional<Board> board;
 
 	if (vm.count("input-file")) {
@@ -102,7 +175,65 @@ int main(int argc, char* argv[]) {
 		}
 	}
 
-	if (vm.count("graphic")) {
+	auto kernel = kernel_from_name(vm["kernel"].as<std::string>());
+	if (!kernel) {
+		std::cerr << "Unknown kernel " << vm["kernel"].as<std::string>() << '\n';
+		return EXIT_FAILURE;
+	}
+	if (!board->set_kernel(*kernel)) {
+		std::cerr << "Kernel " << kernel_name(*kernel) <<
+			" is not supported by this cpu\n";
+		return EXIT_FAILURE;
+	}
+
+	if (vm.count("threads")) {
+		int threads = vm["threads"].as<int>();
+		if (threads == 0)
+			threads = std::thread::hardware_concurrency();
+		board->set_threads(threads);
+	}
+
+	auto topology = topology_from_name(vm["topology"].as<std::string>());
+	if (!topology) {
+		std::cerr << "Unknown topology " <<
+			vm["topology"].as<std::string>() << '\n';
+		return EXIT_FAILURE;
+	}
+	board->set_topology(*topology);
+
+	auto algorithm = algorithm_from_name(vm["engine"].as<std::string>());
+	if (!algorithm) {
+		std::cerr << "Unknown engine " << vm["engine"].as<std::string>() << '\n';
+		return EXIT_FAILURE;
+	}
+	if (!board->set_algorithm(*algorithm)) {
+		std::cerr << "Engine " << algorithm_name(*algorithm) <<
+			" does not support this rule or topology\n";
+		return EXIT_FAILURE;
+	}
+	if (vm.count("tile-size"))
+		board->set_tile_size(vm["tile-size"].as<int>());
+	if (vm.count("tile-generations"))
+		board->set_tile_generations(vm["tile-generations"].as<int>());
+	if (vm.count("hashlife-step"))
+		board->set_step_log(vm["hashlife-step"].as<int>());
+	if (vm.count("history"))
+		board->set_history(vm["history"].as<int>());
+
+	// the board moves into the engine, its pool is shared
+	auto pool = board->thread_pool();
+
+	if (vm.count("headless")) {
+		if (!vm.count("max-iterations")) {
+			std::cerr << "Headless run needs --max-iterations\n";
+			return EXIT_FAILURE;
+		}
+		std::optional<std::string> output;
+		if (vm.count("output"))
+			output = vm["output"].as<std::string>();
+		run_headless(*board, vm["max-iterations"].as<int>(), output);
+	}
+	else if (vm.count("graphic")) {
 		sf::RenderWindow window(sf::VideoMode(800, 600), "My window");
 		Engine<sf::RenderWindow&> engine(window, std::move(*board));
 
@@ -116,6 +247,12 @@ int main(int argc, char* argv[]) {
 		engine.loop();
 	}
 	else {
+		auto glyphs = glyphs_from_name(vm["glyphs"].as<std::string>());
+		if (!glyphs) {
+			std::cerr << "Unknown glyphs " <<
+				vm["glyphs"].as<std::string>() << '\n';
+			return EXIT_FAILURE;
+		}
 		Engine<WINDOW*> engine(stdscr, std::move(*board));
 
 		// setting engine
@@ -123,11 +260,12 @@ int main(int argc, char* argv[]) {
 			engine.setMaxIterations(vm["max-iterations"].as<int>());
 		if (vm.count("speed"))
 			engine.setSpeed(vm["speed"].as<double>());
+		engine.setGlyphs(*glyphs);
 
 
 		engine.loop();
 	}
 
-
-
+	if (vm.count("thread-stats") && pool)
+		print_thread_stats(*pool);
 }
@@ -0,0 +1,91 @@
+#include <algorithm>
+
+#include "morton_grid.hpp"
+
+// bits of value spread to the even positions
+static std::uint64_t spread_bits(std::uint32_t value) {
+	std::uint64_t result = value;
+	result = (result | result << 16) & 0x0000ffff0000ffffull;
+	result = (result | result << 8) & 0x00ff00ff00ff00ffull;
+	result = (result | result << 4) & 0x0f0f0f0f0f0f0f0full;
+	result = (result | result << 2) & 0x3333333333333333ull;
+	result = (result | result << 1) & 0x5555555555555555ull;
+	return result;
+}
+
+MortonGrid::MortonGrid(int height, int width) :
+		m_width(width), m_height(height),
+		m_tiles_x((width + tile_size - 1) / tile_size),
+		m_tiles_y((height + tile_size - 1) / tile_size) {
+	// z-order of the tiles of a board that is not a power of two square,
+	// with the missing tiles left out
+	m_tiles.resize(tile_count());
+	for (int tile = 0; tile < tile_count(); ++tile)
+		m_tiles[tile] = tile;
+	auto code = [&](int tile) {
+		return spread_bits(tile / m_tiles_x) << 1 | spread_bits(tile % m_tiles_x);
+	};
+	std::sort(m_tiles.begin(), m_tiles.end(), [&](int a, int b) {
+		return code(a) < code(b);
+	});
+	m_slots.resize(tile_count());
+	for (int slot = 0; slot < tile_count(); ++slot)
+		m_slots[m_tiles[slot]] = slot;
+
+	auto tail_bits = width - (m_tiles_x - 1) * tile_size;
+	m_tail_mask = tail_bits >= tile_size ?
+		~word_t(0) : (word_t(1) << tail_bits) - 1;
+	m_tail_rows = height - (m_tiles_y - 1) * tile_size;
+
+	// a whole tile is 512 bytes, a multiple of the cache line
+	m_words = GridBuffer<word_t>(
+			static_cast<std::size_t>(tile_count() + 1) * tile_size);
+	m_words.fill_zero();
+}
+
+void MortonGrid::set(int row, int col, bool value) {
+	auto& word = slot(slot_of(row / tile_size, col / tile_size))[row % tile_size];
+	auto bit = word_t(1) << (col % tile_size);
+	if (value)
+		word |= bit;
+	else
+		word &= ~bit;
+}
+
+void MortonGrid::load(const BitGrid& grid) {
+	for (int slot = 0; slot < tile_count(); ++slot) {
+		auto [tile_y, tile_x] = tile_of(slot);
+		auto words = this->slot(slot);
+		for (int row = 0; row < tile_size; ++row) {
+			auto grid_row = tile_y * tile_size + row;
+			words[row] = grid_row < m_height ? grid.row(grid_row)[tile_x + 1] : 0;
+		}
+	}
+}
+
+void MortonGrid::store(BitGrid& grid) const {
+	for (int slot = 0; slot < tile_count(); ++slot) {
+		auto [tile_y, tile_x] = tile_of(slot);
+		auto words = this->slot(slot);
+		auto rows = tile_y == m_tiles_y - 1 ? m_tail_rows : tile_size;
+		for (int row = 0; row < rows; ++row)
+			grid.row(tile_y * tile_size + row)[tile_x + 1] = words[row];
+	}
+}
+
+void life_step_slot(const MortonGrid& src, MortonGrid& dst, int slot,
+		life_tile_kernel_t kernel, RuleMasks rule) {
+	auto [tile_y, tile_x] = src.tile_of(slot);
+	const MortonGrid::word_t* neighbours[9];
+	for (int y = 0; y < 3; ++y)
+		for (int x = 0; x < 3; ++x)
+			neighbours[y * 3 + x] = src.tile(tile_y + y - 1, tile_x + x - 1);
+
+	auto out = dst.slot(slot);
+	kernel(neighbours, out, rule);
+	if (tile_x == src.m_tiles_x - 1)
+		for (int row = 0; row < MortonGrid::tile_size; ++row)
+			out[row] &= src.m_tail_mask;
+	if (tile_y == src.m_tiles_y - 1)
+		std::fill(out + src.m_tail_rows, out + MortonGrid::tile_size, 0);
+}
@@ -0,0 +1,294 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <boost/program_options.hpp>
+
+#include "rtl_parser.hpp"
+
+namespace po = boost::program_options;
+
+// Generates large rtl files in memory and times the lexer alone and the
+// whole parser on them. The parser's own share is the difference, as it
+// pulls every token through the same lexer.
+
+struct Corpus {
+	std::string name;
+	std::string text;
+	// of the board it describes
+	long cells;
+	// live ones, checked after parsing
+	long population;
+	// col of the first live cell in row 0, also checked unless -1
+	int first_live;
+};
+
+// identifiers are letters only, a digit would start a number
+static std::string identifier(const std::string& prefix, int index) {
+	std::string result = prefix;
+	do {
+		result += static_cast<char>('a' + index % 26);
+		index /= 26;
+	} while (index);
+	return result;
+}
+
+// rle body of a random board, lines broken at 70 columns; run lengths go
+// through count, which writes one. Returns the live cells.
+static long write_pattern(std::string& text, int width, int height,
+		double density, std::mt19937& random,
+		const std::function<void(std::string&, int)>& count) {
+	std::bernoulli_distribution alive(density);
+	std::size_t line_start = text.size();
+	auto put = [&](const std::string& token) {
+		if (text.size() - line_start + token.size() > 70) {
+			text += '\n';
+			line_start = text.size();
+		}
+		text += token;
+	};
+
+	std::string token;
+	long population = 0;
+	for (int row = 0; row < height; ++row) {
+		int col = 0;
+		while (col < width) {
+			auto state = alive(random);
+			int run = 1;
+			while (col + run < width && alive(random) == state)
+				++run;
+			col += run;
+			if (state)
+				population += run;
+			token.clear();
+			if (run > 1)
+				count(token, run);
+			token += state ? 'o' : 'b';
+			put(token);
+		}
+		put(row + 1 < height ? "$" : "!");
+	}
+	text += '\n';
+	return population;
+}
+
+static void write_header(std::string& text, int width, int height,
+		const std::string& rule = "B3/S23") {
+	text += "#N synthetic benchmark pattern\n";
+	text += "x = " + std::to_string(width) + ", y = " +
+		std::to_string(height) + ", rule = " + rule;
+}
+
+// plain run lengths, the common case of large pattern files
+static Corpus rle_corpus(int side, std::mt19937& random) {
+	Corpus result = { "rle", "", long(side) * side, 0, -1 };
+	write_header(result.text, side, side);
+	result.text += '\n';
+	result.population = write_pattern(result.text, side, side, 0.3, random,
+			[](std::string& token, int run) { token += std::to_string(run); });
+	return result;
+}
+
+// many variables defined by expressions, and run lengths read from them
+static Corpus expression_corpus(int side, int statements,
+		std::mt19937& random) {
+	Corpus result = { "expressions", "", long(side) * side, 0, -1 };
+	write_header(result.text, side, side);
+
+	// k<n> holds n; expressions only read these, so every value stays small
+	constexpr int constants = 16;
+	for (int i = 0; i < constants; ++i)
+		result.text += ",\n" + identifier("k", i) + " = " + std::to_string(i);
+	std::uniform_int_distribution<int> constant(1, constants - 1);
+	for (int i = 0; i < statements; ++i) {
+		result.text += ",\n" + identifier("v", i) + " = %((" +
+			identifier("k", constant(random)) + " + " +
+			std::to_string(constant(random)) + ") * " +
+			identifier("k", constant(random)) + " - " +
+			identifier("k", constant(random)) + " / " +
+			std::to_string(constant(random)) + ")";
+	}
+	result.text += '\n';
+
+	result.population = write_pattern(result.text, side, side, 0.3, random,
+			[&](std::string& token, int run) {
+		if (run < constants)
+			token += "%(" + identifier("k", run) + ")";
+		else
+			token += std::to_string(run);
+	});
+	return result;
+}
+
+// if statements nested depth deep: a false branch that is skipped, an
+// elsif that is taken and an else that is skipped after it
+static Corpus nesting_corpus(int side, int blocks, int depth,
+		std::mt19937& random) {
+	Corpus result = { "nesting", "", long(side) * side, 0, -1 };
+	write_header(result.text, side, side);
+	result.text += ",\nzero = 0, unit = 1";
+
+	std::function<void(int)> nest = [&](int level) {
+		if (!level) {
+			result.text += "w = " + std::to_string(random() % 100);
+			return;
+		}
+		result.text += "if %(zero)\n\tw = 1\nelsif %(unit)\n";
+		nest(level - 1);
+		result.text += "\nelse\n\tw = 2\nendif";
+	};
+	for (int i = 0; i < blocks; ++i) {
+		result.text += ",\n";
+		nest(depth);
+	}
+	result.text += '\n';
+
+	result.population = write_pattern(result.text, side, side, 0.3, random,
+			[](std::string& token, int run) { token += std::to_string(run); });
+	return result;
+}
+
+// an empty survival list right before a line that starts with a run
+// length, which must not be read as a condition
+static Corpus seeds_corpus(int side, std::mt19937& random) {
+	Corpus result = { "seeds", "", long(side) * side, side - 3, 3 };
+	write_header(result.text, side, side, "B2/S");
+	result.text += "\n3b" + std::to_string(side - 3) + "o$";
+	result.population += write_pattern(result.text, side, side - 1, 0.3,
+			random, [](std::string& token, int run) {
+		token += std::to_string(run);
+	});
+	return result;
+}
+
+static long population(const Board& board) {
+	auto& grid = board.generation(0);
+	long result = 0;
+	for (int row = 0; row < grid.height(); ++row)
+		for (int word = 1; word <= grid.last_word(); ++word)
+			result += __builtin_popcountll(grid.row(row)[word]);
+	return result;
+}
+
+static int first_live(const Board& board) {
+	for (int col = 0; col < board.width(); ++col)
+		if (board.generation(0).get(0, col))
+			return col;
+	return -1;
+}
+
+// best of repeats, in seconds
+template <class Function>
+static double best_time(int repeats, Function&& function) {
+	double best = 0;
+	for (int i = 0; i < repeats; ++i) {
+		auto start = std::chrono::steady_clock::now();
+		function();
+		std::chrono::duration<double> elapsed =
+			std::chrono::steady_clock::now() - start;
+		if (!i || elapsed.count() < best)
+			best = elapsed.count();
+	}
+	return best;
+}
+
+int main(int argc, char* argv[]) {
+	po::options_description desc("Allowed options");
+	desc.add_options()
+		("help", "print this text")
+		("side", po::value<int>()->default_value(2048),
+			"side of the generated boards in cells")
+		("statements", po::value<int>()->default_value(100000),
+			"variables of the expression corpus")
+		("blocks", po::value<int>()->default_value(2000),
+			"nested if statements of the nesting corpus")
+		("depth", po::value<int>()->default_value(32),
+			"nesting depth of each of them")
+		("repeats", po::value<int>()->default_value(3),
+			"measurements of each corpus, the best one counts")
+		("seed", po::value<unsigned>()->default_value(1),
+			"seed of the generated patterns")
+		("save", po::value<std::string>(),
+			"also write the corpus files to this directory")
+		("output,o", po::value<std::string>(),
+			"file the JSON goes to (default stdout)")
+		;
+
+	po::variables_map vm;
+	po::store(po::parse_command_line(argc, argv, desc), vm);
+	po::notify(vm);
+
+	if (vm.count("help")) {
+		std::cout << desc << '\n';
+		return EXIT_SUCCESS;
+	}
+
+	auto side = vm["side"].as<int>();
+	auto repeats = std::max(vm["repeats"].as<int>(), 1);
+	std::mt19937 random(vm["seed"].as<unsigned>());
+	std::vector<Corpus> corpora;
+	corpora.push_back(rle_corpus(side, random));
+	corpora.push_back(expression_corpus(side,
+				vm["statements"].as<int>(), random));
+	corpora.push_back(nesting_corpus(side, vm["blocks"].as<int>(),
+				vm["depth"].as<int>(), random));
+	corpora.push_back(seeds_corpus(side, random));
+
+	if (vm.count("save"))
+		for (auto&& corpus : corpora)
+			std::ofstream(vm["save"].as<std::string>() + '/' +
+					corpus.name + ".rtl") << corpus.text;
+
+	std::ofstream file;
+	if (vm.count("output"))
+		file.open(vm["output"].as<std::string>());
+	std::ostream& out = vm.count("output") ? file : std::cout;
+
+	out << "{\n";
+	out << "  \"build_type\": \"" << GAME_OF_LIFE_BUILD_TYPE << "\",\n";
+	out << "  \"compiler\": \"" << GAME_OF_LIFE_COMPILER << "\",\n";
+	out << "  \"cxx_flags\": \"" << GAME_OF_LIFE_CXX_FLAGS << "\",\n";
+	out << "  \"results\": [";
+	bool first = true;
+	for (auto&& corpus : corpora) {
+		long tokens = 0;
+		auto lex_seconds = best_time(repeats, [&]() {
+			std::istringstream stream(corpus.text);
+			tokens = lex_stream(stream);
+		});
+		bool parsed = true;
+		auto parse_seconds = best_time(repeats, [&]() {
+			std::istringstream stream(corpus.text);
+			auto board = parse_from_stream(stream, corpus.name);
+			parsed = board && population(*board) == corpus.population &&
+				(corpus.first_live < 0 ||
+				 first_live(*board) == corpus.first_live);
+		});
+		if (tokens < 0 || !parsed) {
+			std::cerr << "Generated " << corpus.name << " corpus is invalid\n";
+			return EXIT_FAILURE;
+		}
+
+		auto megabytes = corpus.text.size() / 1e6;
+		auto parser_seconds = std::max(parse_seconds - lex_seconds, 1e-9);
+		out << (first ? "\n" : ",\n");
+		first = false;
+		out << "    {\"corpus\": \"" << corpus.name << "\", " <<
+			"\"bytes\": " << corpus.text.size() << ", " <<
+			"\"tokens\": " << tokens << ", " <<
+			"\"cells\": " << corpus.cells << ", " <<
+			"\"lex_seconds\": " << lex_seconds << ", " <<
+			"\"parse_seconds\": " << parse_seconds << ", " <<
+			"\"lexer_mb_per_second\": " << megabytes / lex_seconds << ", " <<
+			"\"parser_mb_per_second\": " << megabytes / parser_seconds << ", " <<
+			"\"total_mb_per_second\": " << megabytes / parse_seconds << ", " <<
+			"\"cells_per_second\": " << corpus.cells / parse_seconds << "}";
+	}
+	out << "\n  ]\n}\n";
+}
@@ -1,4 +1,5 @@
 #include "rtl_parser.hpp"
+#include <algorithm>
 #include <optional>
 #include <istream>
 #include <fstream>
@@ -6,6 +7,7 @@
 #include <cassert>
 #include <initializer_list>
 #include <map>
+#include <tuple>
 
 #define PARSE_ANYWAY
 #define MAX_ERROR_COUNT 4
@@ -119,12 +121,18 @@ public:
 		return m_col_nr;
 	}
 
+	// whitespace between the last token and the one before
+	bool get_space_before() {
+		return m_space_before;
+	}
+
 private:
 	std::istream& m_stream;
 	int m_line_nr;
 	int m_col_nr;
 	// one previous col
 	int m_previous_col_len;
+	bool m_space_before;
 
 	auto get_char() {
 		auto result = m_stream.get();
@@ -185,12 +193,14 @@ private:
 Lexer::Lexer(std::istream& stream) : m_stream(stream) {
 	m_line_nr = 1;
 	m_col_nr = 1;
+	m_space_before = false;
 }
 
 std::pair<Token, std::string> Lexer::lex() {
 	constexpr auto eof = std::istream::traits_type::eof();
 	bool get_more = false;
 	decltype(get_char()) c;
+	m_space_before = false;
 	do {
 		c = get_char();
 		get_more = false;
@@ -305,6 +315,7 @@ std::pair<Token, std::string> Lexer::lex() {
 		case '\n':
 		case '\t':
 			get_more = true;
+			m_space_before = true;
 		}
 	}
 	while (get_more);
@@ -330,7 +341,14 @@ std::pair<Token, std::string> Lexer::lex() {
  *
  * value_description = _IDENTIFIER, _EQUALS, ( [ _MINUS ], _NUMBER | expression_value );
  *
- * rule_description = _B, _NUMBER, _SLASH, _S, _NUMBER;
+ * rule_description = _B, rule_conditions, _SLASH, _S, rule_conditions
+ *                  | range_rule_description;
+ *
+ * rule_conditions = { _NUMBER | _MINUS | _IDENTIFIER }; (without whitespace)
+ *
+ * range_rule_description = _IDENTIFIER (r | R), _NUMBER, _SLASH, _B, count_interval, _SLASH, _S, count_interval;
+ *
+ * count_interval = [ _NUMBER, [ _MINUS, _NUMBER ] ];
  *
  * pattern_section = line_pattern, { _DOLAR, line_pattern }, _EXCLAMATION_MARK;
  *
@@ -366,10 +384,16 @@ private:
 	std::optional<Board> m_board;
 	std::set<int> m_survives;
 	std::set<int> m_born;
+	bool m_rule_set;
+	// rule with letters, e.g. B2-a/S12
+	std::optional<IsotropicRule> m_isotropic_rule;
+	// Larger than Life, e.g. R5/B34-45/S34-58
+	std::optional<LargerThanLifeRule> m_range_rule;
 	Board::Position m_position;
 	std::map<std::string, int> m_values;
 
 	Token m_current_symbol;
+	bool m_current_spaced;
 	std::string m_current_text;
 	std::pair<int, int> m_source_position;
 	std::string m_cached_text;
@@ -390,6 +414,7 @@ private:
 	void rtl_file();
 	void comment_section();
 	void header_section();
+	void create_board();
 	void statement();
 	void function_call();
 	void if_statement();
@@ -397,6 +422,9 @@ private:
 	bool m_during_print_call;
 	void value_description();
 	void rule_description();
+	std::string rule_conditions();
+	void range_rule_description();
+	std::pair<int, int> count_interval();
 	void pattern_section();
 	void line_pattern();
 	void pattern();
@@ -415,8 +443,10 @@ Parser::Parser() {
 	m_error_count = 0;
 	m_inside_expression = false;
 	m_current_symbol = _EOF;
+	m_current_spaced = false;
 
 	m_during_print_call = false;
+	m_rule_set = false;
 }
 
 bool Parser::accept(Token symbol) {
@@ -460,6 +490,7 @@ void Parser::next_symbol() {
 	update_position();
 	auto pair = m_lex->lex();
 	m_current_symbol = pair.first;
+	m_current_spaced = m_lex->get_space_before();
 	m_current_text = m_cached_text;
 	m_cached_text = pair.second;
 
@@ -488,6 +519,7 @@ void Parser::update_position() {
 void Parser::rtl_file() {
 	comment_section();
 	header_section();
+	create_board();
 	pattern_section();
 }
 
@@ -502,7 +534,10 @@ void Parser::header_section() {
 			statement();
 
 	}
+}
 
+// from the values the header left, once all branches are taken
+void Parser::create_board() {
 	int x, y;
 	bool valid = true;
 	if (!m_values.count("x")) {
@@ -519,7 +554,7 @@ void Parser::header_section() {
 	else
 		y = m_values["y"];
 
-	if (m_born.empty() || m_survives.empty()) {
+	if (!m_rule_set) {
 		warning("rule not set. Using default - B3/S23");
 		m_born.insert(3);
 		m_survives.insert({2, 3});
@@ -535,6 +570,11 @@ void Parser::header_section() {
 	if (!valid)
 		return;
 	m_board = Board(y, x);
+	m_board->set_rules(m_survives, m_born);
+	if (m_isotropic_rule)
+		m_board->set_rules(*m_isotropic_rule);
+	if (m_range_rule)
+		m_board->set_rules(*m_range_rule);
 	m_position = m_board->begin();
 }
 
@@ -683,15 +723,80 @@ void Parser::value_description() {
 }
 
 void Parser::rule_description() {
+	m_born.clear();
+	m_survives.clear();
+	m_isotropic_rule.reset();
+	m_range_rule.reset();
+	m_rule_set = true;
+	if (ask(_IDENTIFIER) && (m_cached_text == "r" || m_cached_text == "R")) {
+		range_rule_description();
+		return;
+	}
+	// either count list may be empty, e.g. seeds - B2/S
 	expect(_B);
-	expect(_NUMBER);
-	for (auto&& iter : m_current_text)
-		m_born.insert(iter - '0');
+	auto born = rule_conditions();
 	expect(_SLASH);
 	expect(_S);
+	auto survives = rule_conditions();
+
+	auto is_digit = [](char c) { return c >= '0' && c <= '9'; };
+	if (std::all_of(born.begin(), born.end(), is_digit) &&
+			std::all_of(survives.begin(), survives.end(), is_digit)) {
+		for (auto&& iter : born)
+			m_born.insert(iter - '0');
+		for (auto&& iter : survives)
+			m_survives.insert(iter - '0');
+		return;
+	}
+
+	m_isotropic_rule = isotropic_rule(born, survives);
+	if (!m_isotropic_rule)
+		error("Invalid rule - B" + born + "/S" + survives);
+}
+
+void Parser::range_rule_description() {
+	expect(_IDENTIFIER);
 	expect(_NUMBER);
-	for (auto&& iter : m_current_text)
-		m_survives.insert(iter - '0');
+	LargerThanLifeRule rule;
+	rule.range = std::stoi(m_current_text);
+	expect(_SLASH);
+	expect(_B);
+	std::tie(rule.born_min, rule.born_max) = count_interval();
+	expect(_SLASH);
+	expect(_S);
+	std::tie(rule.survives_min, rule.survives_max) = count_interval();
+
+	if (rule.range < 1 || rule.range > LargerThanLifeRule::max_range)
+		error("Invalid rule range - " + std::to_string(rule.range));
+	else
+		m_range_rule = rule;
+}
+
+// empty interval as (1, 0)
+std::pair<int, int> Parser::count_interval() {
+	// the pattern may follow an empty interval on the next line
+	if (m_current_spaced || !accept(_NUMBER))
+		return { 1, 0 };
+	auto min = std::stoi(m_current_text);
+	auto max = min;
+	if (accept(_MINUS)) {
+		expect(_NUMBER);
+		max = std::stoi(m_current_text);
+	}
+	return { min, max };
+}
+
+// a pattern may follow the rule on the next line, so the conditions end
+// at the first whitespace, even an empty list, like count_interval()
+std::string Parser::rule_conditions() {
+	std::string result;
+	while (ask({_NUMBER, _MINUS, _IDENTIFIER})) {
+		if (m_current_spaced)
+			break;
+		next_symbol();
+		result += m_current_text;
+	}
+	return result;
 }
 
 void Parser::pattern_section() {
@@ -721,7 +826,7 @@ void Parser::pattern_section() {
 
 void Parser::line_pattern() {
 	pattern();
-	while (ask({_NUMBER, _B, _O}))
+	while (ask({_NUMBER, _PERCENT, _B, _O}))
 		pattern();
 }
 
@@ -731,8 +836,10 @@ void Parser::pattern() {
 		repetitions = std::stoi(m_current_text);
 	else if (ask(_PERCENT)) {
 		repetitions = expression_value();
-		error("Negative value of expression '" + m_expression_desc + '\'');
-		return;
+		if (repetitions < 0) {
+			error("Negative value of expression '" + m_expression_desc + '\'');
+			return;
+		}
 	}
 	if (accept(_B)) {
 		while (repetitions--)
@@ -865,13 +972,30 @@ std::optional<Board> Parser::parse_stream(std::istream& stream, const std::strin
 
 std::optional<Board> parse_from_file(const std::string& name) {
 	std::ifstream stream(name);
-	Parser parser;
-	return parser.parse_stream(stream, name);
+	return parse_from_stream(stream, name);
 }
 
 std::optional<Board> parse_from_stdin() {
+	return parse_from_stream(std::cin, "stdin");
+}
+
+std::optional<Board> parse_from_stream(std::istream& stream,
+		const std::string& name) {
 	Parser parser;
-	return parser.parse_stream(std::cin, "stdin");
+	return parser.parse_stream(stream, name);
+}
+
+long lex_stream(std::istream& stream) {
+	Lexer lexer(stream);
+	long tokens = 0;
+	while (true) {
+		auto token = lexer.lex().first;
+		if (token == _EOF)
+			return tokens;
+		if (token < 0)
+			return -1;
+		++tokens;
+	}
 }
 
 
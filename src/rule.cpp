@@ -0,0 +1,135 @@
+#include <cctype>
+
+#include "rule.hpp"
+
+// letters for 1-4 neighbours with one neighbourhood each, the rest of a
+// class are its rotations and reflections; 5-7 neighbours use the
+// complements of 3-1 with the same letters
+static const char* const hensel_letters[5] = {
+	"", "ce", "ceaikn", "ceaiknjqry", "ceaiknjqrytwz"
+};
+static const int hensel_neighbourhoods[5][13] = {
+	{ },
+	{ 1, 2 },
+	{ 5, 10, 3, 40, 33, 68 },
+	{ 69, 42, 11, 7, 98, 13, 14, 70, 41, 97 },
+	{ 325, 170, 15, 45, 99, 71, 106, 102, 43, 101, 105, 78, 108 },
+};
+
+static constexpr int centre_bit = 1 << 4;
+static constexpr int neighbour_bits = 511 ^ centre_bit;
+
+static int transform(int neighbourhood, int rotations, bool mirror) {
+	int result = 0;
+	for (int bit = 0; bit < 9; ++bit) {
+		if (!((neighbourhood >> bit) & 1))
+			continue;
+		int row = bit / 3;
+		int col = bit % 3;
+		if (mirror)
+			col = 2 - col;
+		for (int i = 0; i < rotations; ++i) {
+			auto previous_row = row;
+			row = col;
+			col = 2 - previous_row;
+		}
+		result |= 1 << (row * 3 + col);
+	}
+	return result;
+}
+
+// letter of every neighbourhood without the centre bit, 0 for 0 and 8
+static std::array<char, 512> letters_table() {
+	std::array<char, 512> result = { };
+	for (int count = 1; count <= 4; ++count) {
+		for (int i = 0; hensel_letters[count][i]; ++i) {
+			for (int rotations = 0; rotations < 4; ++rotations) {
+				for (auto mirror : { false, true }) {
+					auto neighbourhood = transform(
+						hensel_neighbourhoods[count][i], rotations, mirror);
+					result[neighbourhood] = hensel_letters[count][i];
+					if (count < 4)
+						result[neighbour_bits ^ neighbourhood] =
+							hensel_letters[count][i];
+				}
+			}
+		}
+	}
+	return result;
+}
+
+static const char* letters_for(int count) {
+	return hensel_letters[count <= 4 ? count : 8 - count];
+}
+
+// allowed[count][letter] for conditions like "2-a3", count 0-8
+static bool parse_conditions(const std::string& conditions,
+		std::array<std::array<bool, 128>, 9>& allowed) {
+	for (auto&& iter : allowed)
+		iter.fill(false);
+
+	std::size_t i = 0;
+	while (i < conditions.size()) {
+		if (!std::isdigit(static_cast<unsigned char>(conditions[i])))
+			return false;
+		int count = conditions[i++] - '0';
+		if (count > 8)
+			return false;
+
+		bool exclude = i < conditions.size() && conditions[i] == '-';
+		if (exclude)
+			++i;
+		std::string letters;
+		while (i < conditions.size() &&
+				std::isalpha(static_cast<unsigned char>(conditions[i])))
+			letters += conditions[i++];
+		if (exclude && letters.empty())
+			return false;
+
+		std::string valid = letters_for(count);
+		for (auto&& letter : letters)
+			if (valid.find(letter) == std::string::npos)
+				return false;
+		// bare count - every letter
+		for (auto&& letter : valid)
+			allowed[count][letter] = letters.empty() ||
+				(exclude != (letters.find(letter) != std::string::npos));
+		if (valid.empty())
+			allowed[count][0] = true;
+	}
+	return true;
+}
+
+std::optional<IsotropicRule> isotropic_rule(const std::string& born,
+		const std::string& survives) {
+	std::array<std::array<bool, 128>, 9> born_allowed;
+	std::array<std::array<bool, 128>, 9> survives_allowed;
+	if (!parse_conditions(born, born_allowed) ||
+			!parse_conditions(survives, survives_allowed))
+		return { };
+
+	static const auto letters = letters_table();
+	IsotropicRule result;
+	result.born = born;
+	result.survives = survives;
+	for (int index = 0; index < 512; ++index) {
+		auto neighbours = index & neighbour_bits;
+		auto count = __builtin_popcount(neighbours);
+		auto& allowed = index & centre_bit ? survives_allowed : born_allowed;
+		result.next[index] = allowed[count][letters[neighbours]];
+	}
+	return result;
+}
+
+std::string rule_name(const LargerThanLifeRule& rule) {
+	auto interval = [](int min, int max) {
+		if (min > max)
+			return std::string();
+		if (min == max)
+			return std::to_string(min);
+		return std::to_string(min) + '-' + std::to_string(max);
+	};
+	return 'R' + std::to_string(rule.range) +
+		"/B" + interval(rule.born_min, rule.born_max) +
+		"/S" + interval(rule.survives_min, rule.survives_max);
+}
@@ -0,0 +1,131 @@
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include "sfml_renderer.hpp"
+
+// pixels per cell, zoomed in as far as it goes
+static constexpr double max_scale = 64;
+
+// rgba bytes in memory order, whatever the endianness
+static std::uint32_t pixel(const sf::Color& color) {
+	const sf::Uint8 bytes[4] = { color.r, color.g, color.b, color.a };
+	std::uint32_t result;
+	std::memcpy(&result, bytes, sizeof(result));
+	return result;
+}
+
+SfmlRenderer::SfmlRenderer(int height, int width) :
+		m_width(std::max(width, 1)), m_height(std::max(height, 1)),
+		m_pyramid(height, width) {
+	// a square root curve, so a lone glider in a large block still shows
+	m_shades[0] = pixel(sf::Color::White);
+	for (int density = 1; density < 256; ++density) {
+		auto grey = static_cast<sf::Uint8>(
+				191 - std::lround(191 * std::sqrt(density / 255.0)));
+		m_shades[density] = pixel(sf::Color(grey, grey, grey));
+	}
+	m_texture.setSmooth(false);
+}
+
+void SfmlRenderer::update(const BitGrid& grid) {
+	m_pyramid.update(grid);
+	m_fresh = false;
+}
+
+void SfmlRenderer::fit(sf::Vector2u size) {
+	m_scale = std::min(static_cast<double>(size.x) / m_width,
+			static_cast<double>(size.y) / m_height);
+	m_scale = std::clamp(m_scale, 1.0 / std::max(m_width, m_height), max_scale);
+	m_left = (m_width - size.x / m_scale) / 2;
+	m_top = (m_height - size.y / m_scale) / 2;
+	m_fresh = false;
+}
+
+void SfmlRenderer::zoom(float factor, sf::Vector2f pixel) {
+	auto col = m_left + pixel.x / m_scale;
+	auto row = m_top + pixel.y / m_scale;
+	m_scale = std::clamp(m_scale * factor,
+			1.0 / std::max(m_width, m_height), max_scale);
+	m_left = col - pixel.x / m_scale;
+	m_top = row - pixel.y / m_scale;
+	m_fresh = false;
+}
+
+void SfmlRenderer::pan(sf::Vector2f pixels) {
+	m_left -= pixels.x / m_scale;
+	m_top -= pixels.y / m_scale;
+	m_fresh = false;
+}
+
+void SfmlRenderer::draw(sf::RenderTarget& target) {
+	auto size = target.getSize();
+	if (!size.x || !size.y)
+		return;
+	if (size.x != m_target_size.x || size.y != m_target_size.y) {
+		m_target_size = size;
+		m_fresh = false;
+	}
+
+	// the finest level whose blocks are at least a pixel wide
+	int level = 0;
+	while (level + 1 < m_pyramid.levels() && (1 << level) * m_scale < 1)
+		++level;
+	auto block = static_cast<double>(1 << level);
+	auto max_size = static_cast<int>(sf::Texture::getMaximumSize());
+	auto col_begin = std::max(0, static_cast<int>(std::floor(m_left / block)));
+	auto row_begin = std::max(0, static_cast<int>(std::floor(m_top / block)));
+	auto col_end = std::min({ m_pyramid.width(level), col_begin + max_size,
+			static_cast<int>(std::ceil((m_left + size.x / m_scale) / block)) });
+	auto row_end = std::min({ m_pyramid.height(level), row_begin + max_size,
+			static_cast<int>(std::ceil((m_top + size.y / m_scale) / block)) });
+	// the board is out of sight
+	if (col_begin >= col_end || row_begin >= row_end)
+		return;
+
+	auto columns = static_cast<unsigned>(col_end - col_begin);
+	auto rows = static_cast<unsigned>(row_end - row_begin);
+	if (!m_fresh) {
+		auto capacity = m_texture.getSize();
+		if (capacity.x < columns || capacity.y < rows) {
+			m_texture.create(std::max(capacity.x, columns),
+					std::max(capacity.y, rows));
+			m_sprite.setTexture(m_texture);
+		}
+		fill(level, row_begin, row_end, col_begin, col_end);
+		m_texture.update(reinterpret_cast<const sf::Uint8*>(m_pixels.data()),
+				columns, rows, 0, 0);
+		m_sprite.setTextureRect(sf::IntRect(0, 0, columns, rows));
+		m_fresh = true;
+	}
+
+	auto texel = static_cast<float>(block * m_scale);
+	m_sprite.setScale(texel, texel);
+	m_sprite.setPosition(static_cast<float>((col_begin * block - m_left) * m_scale),
+			static_cast<float>((row_begin * block - m_top) * m_scale));
+	target.draw(m_sprite);
+}
+
+void SfmlRenderer::fill(int level, int row_begin, int row_end,
+		int col_begin, int col_end) {
+	auto columns = col_end - col_begin;
+	m_pixels.resize(static_cast<std::size_t>(columns) * (row_end - row_begin));
+	auto out = m_pixels.data();
+	if (!level) {
+		auto& cells = m_pyramid.cells();
+		for (int row = row_begin; row < row_end; ++row)
+			for (int col = col_begin; col < col_end; ++col)
+				*out++ = m_shades[cells.get(row, col) ? 255 : 0];
+		return;
+	}
+
+	// density in 1/255, any live cell at least 1
+	auto area_bits = 2 * level;
+	for (int row = row_begin; row < row_end; ++row) {
+		for (int col = col_begin; col < col_end; ++col) {
+			std::uint64_t count = m_pyramid.count(level, row, col);
+			auto density = (count * 255) >> area_bits;
+			*out++ = m_shades[count ? std::max<std::uint64_t>(density, 1) : 0];
+		}
+	}
+}
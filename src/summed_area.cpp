@@ -0,0 +1,66 @@
+#include <algorithm>
+
+#include "summed_area.hpp"
+
+// sums of the extended rectangle, row 0 of sums already zero
+template <class Policy>
+static void sum_rows(const BitGrid& grid, int range, int row_begin,
+		int rows, int col_begin, int cols, std::uint32_t* sums, int stride) {
+	auto height = grid.height();
+	auto width = grid.width();
+	for (int row = 0; row < rows; ++row) {
+		auto previous = sums + static_cast<std::size_t>(row) * stride;
+		auto current = previous + stride;
+		std::uint32_t line = 0;
+		current[0] = 0;
+		for (int col = 0; col < cols; ++col) {
+			int grid_row = row_begin - range + row;
+			int grid_col = col_begin - range + col;
+			if (grid_row >= 0 && grid_row < height &&
+					grid_col >= 0 && grid_col < width)
+				line += grid.get(grid_row, grid_col);
+			else if (Policy::map(grid_row, grid_col, height, width))
+				line += grid.get(grid_row, grid_col);
+			current[col + 1] = previous[col + 1] + line;
+		}
+	}
+}
+
+void SummedAreaTable::build(const BitGrid& grid, int range,
+		Topology topology, int row_begin, int row_end, int col_begin,
+		int col_end) {
+	m_range = range;
+	m_row = row_begin;
+	m_col = col_begin;
+	auto rows = row_end - row_begin + 2 * range;
+	auto cols = col_end - col_begin + 2 * range;
+	m_stride = cols + 1;
+	m_sums.resize(static_cast<std::size_t>(rows + 1) * m_stride);
+	std::fill(m_sums.begin(), m_sums.begin() + m_stride, 0);
+	with_topology(topology, [&](auto policy) {
+		sum_rows<decltype(policy)>(grid, range, row_begin, rows,
+				col_begin, cols, m_sums.data(), m_stride);
+	});
+}
+
+void life_step_range(const SummedAreaTable& sums, const BitGrid& src,
+		BitGrid& dst, int row_begin, int row_end, int word_begin,
+		int word_end, const LargerThanLifeRule& rule) {
+	for (int row = row_begin; row < row_end; ++row) {
+		auto current = src.row(row);
+		auto out = dst.row(row);
+		for (int word = word_begin; word < word_end; ++word) {
+			auto first_col = (word - 1) * BitGrid::word_bits;
+			auto bits = std::min(BitGrid::word_bits, src.width() - first_col);
+			BitGrid::word_t result = 0;
+			for (int bit = 0; bit < bits; ++bit) {
+				int count = sums.count(row, first_col + bit);
+				bool next = (current[word] >> bit) & 1 ?
+					count >= rule.survives_min && count <= rule.survives_max :
+					count >= rule.born_min && count <= rule.born_max;
+				result |= BitGrid::word_t(next) << bit;
+			}
+			out[word] = result;
+		}
+	}
+}
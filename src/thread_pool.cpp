@@ -0,0 +1,153 @@
+#include <algorithm>
+
+#include "thread_pool.hpp"
+
+static thread_local int current_thread_index = 0;
+
+ThreadPool::ThreadPool(int threads) :
+		m_ranges(new TaskRange[std::max(threads, 1)]),
+		m_stats(std::max(threads, 1)) {
+	for (int i = 1; i < threads; ++i)
+		m_workers.emplace_back([this, i]() {
+			current_thread_index = i;
+			worker_loop(i);
+		});
+}
+
+int ThreadPool::thread_index() {
+	return current_thread_index;
+}
+
+ThreadPool::~ThreadPool() {
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_stop = true;
+	}
+	m_start.notify_all();
+	for (auto&& iter : m_workers)
+		iter.join();
+}
+
+void ThreadPool::reset_stats() {
+	m_stats.assign(m_stats.size(), Stats());
+	m_run_time = std::chrono::nanoseconds(0);
+}
+
+void ThreadPool::run_tasks(int tasks, task_fn_t function, void* context,
+		bool stealing) {
+	auto start = std::chrono::steady_clock::now();
+	m_function = function;
+	m_context = context;
+
+	if (m_workers.empty() || tasks <= 1) {
+		for (int i = 0; i < tasks; ++i)
+			run_task(0, i);
+		m_run_time += std::chrono::steady_clock::now() - start;
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_tasks = tasks;
+		m_next_task = 0;
+		m_stealing = stealing;
+		if (stealing) {
+			auto threads = size();
+			for (int i = 0; i < threads; ++i) {
+				m_ranges[i].begin = static_cast<long>(tasks) * i / threads;
+				m_ranges[i].end = static_cast<long>(tasks) * (i + 1) / threads;
+			}
+		}
+		m_running = static_cast<int>(m_workers.size());
+		++m_generation;
+	}
+	m_start.notify_all();
+
+	if (stealing)
+		work_stealing(0);
+	else
+		work(0);
+
+	std::unique_lock<std::mutex> lock(m_mutex);
+	m_done.wait(lock, [this]() { return m_running == 0; });
+	m_run_time += std::chrono::steady_clock::now() - start;
+}
+
+void ThreadPool::run_task(int thread, int index) {
+	auto start = std::chrono::steady_clock::now();
+	m_function(m_context, index);
+	auto& stats = m_stats[thread];
+	stats.busy += std::chrono::steady_clock::now() - start;
+	++stats.tasks;
+}
+
+void ThreadPool::work(int thread) {
+	int index;
+	while ((index = m_next_task.fetch_add(1)) < m_tasks)
+		run_task(thread, index);
+}
+
+void ThreadPool::work_stealing(int thread) {
+	auto& own = m_ranges[thread];
+	while (true) {
+		int index = -1;
+		{
+			std::lock_guard<std::mutex> lock(own.mutex);
+			if (own.begin < own.end)
+				index = --own.end;
+		}
+		if (index >= 0)
+			run_task(thread, index);
+		else if (!steal(thread))
+			return;
+	}
+}
+
+// every range is empty once a whole round finds nothing, tasks still
+// running cannot add new ones
+bool ThreadPool::steal(int thread) {
+	auto threads = size();
+	for (int i = 1; i < threads; ++i) {
+		auto& victim = m_ranges[(thread + i) % threads];
+		int begin, end;
+		{
+			std::lock_guard<std::mutex> lock(victim.mutex);
+			if (victim.begin >= victim.end)
+				continue;
+			begin = victim.begin;
+			end = begin + (victim.end - begin + 1) / 2;
+			victim.begin = end;
+		}
+		auto& own = m_ranges[thread];
+		std::lock_guard<std::mutex> lock(own.mutex);
+		own.begin = begin;
+		own.end = end;
+		++m_stats[thread].steals;
+		return true;
+	}
+	return false;
+}
+
+void ThreadPool::worker_loop(int thread) {
+	unsigned long generation = 0;
+	while (true) {
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_start.wait(lock, [&]() {
+				return m_stop || m_generation != generation;
+			});
+			if (m_stop)
+				return;
+			generation = m_generation;
+		}
+
+		if (m_stealing)
+			work_stealing(thread);
+		else
+			work(thread);
+
+		std::lock_guard<std::mutex> lock(m_mutex);
+		if (--m_running == 0)
+			m_done.notify_one();
+	}
+}
@@ -0,0 +1,56 @@
+#include "topology.hpp"
+
+template <class Policy>
+static void fill_halo(BitGrid& grid) {
+	auto height = grid.height();
+	auto width = grid.width();
+	auto fill = [&](int row, int col) {
+		int source_row = row;
+		int source_col = col;
+		grid.set(row, col, Policy::map(source_row, source_col, height, width) &&
+				grid.get(source_row, source_col));
+	};
+	for (int row = 0; row < height; ++row) {
+		fill(row, -1);
+		fill(row, width);
+	}
+	for (int col = -1; col <= width; ++col) {
+		fill(-1, col);
+		fill(height, col);
+	}
+}
+
+// whole words instead of cells
+template <>
+void fill_halo<TorusTopology>(BitGrid& grid) {
+	grid.wrap_halo();
+}
+
+void fill_halo(BitGrid& grid, Topology topology) {
+	if (!grid.width() || !grid.height())
+		return;
+	with_topology(topology, [&](auto policy) {
+		fill_halo<decltype(policy)>(grid);
+	});
+}
+
+const char* topology_name(Topology topology) {
+	switch (topology) {
+	case Topology::torus:
+		return "torus";
+	case Topology::klein:
+		return "klein";
+	case Topology::cross:
+		return "cross";
+	default:
+		return "plane";
+	}
+}
+
+std::optional<Topology> topology_from_name(const std::string& name) {
+	for (auto topology : { Topology::plane, Topology::torus,
+			Topology::klein, Topology::cross })
+		if (name == topology_name(topology))
+			return topology;
+	return { };
+}